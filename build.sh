@@ -1,6 +1,6 @@
 include="-Ilib/raylib/src -Ilib/lua-5.4.6/src -Ilib/miniaudio/ -Ilib/jsmn -Ilib/curl-8.5.0/include"
 linker="-lraylib -llua -L./lib/raylib/src/ -L./lib/lua-5.4.6/src -framework CoreVideo -framework IOKit -framework Cocoa -framework GLUT -framework OpenGL -lcurl"
-src="src/lmath.c src/hashmap.c src/main.c src/state.c src/ffmpeg_unix.c src/signals.c src/renderer.c src/parameter.c src/api.c src/arena.c src/permanent_storage.c src/loopback.c src/server.c src/json.c src/thread_unix.c src/animation.c src/procedures.c"
+src="src/lmath.c src/hashmap.c src/main.c src/state.c src/ffmpeg_unix.c src/signals.c src/renderer.c src/parameter.c src/api.c src/arena.c src/permanent_storage.c src/loopback.c src/server.c src/json.c src/thread_unix.c src/animation.c src/procedures.c src/resampler.c src/sample_ring.c src/loader.c src/decoder.c src/track.c src/player.c src/pcm_queue.c src/mutex.c src/pcm_cache.c src/pool.c src/spectrogram.c src/history.c src/capture.c src/stems.c src/realtime.c src/playlist.c src/free_list.c src/alloc.c src/intern.c"
 
 mkdir -p build
 
@@ -6,3 +6,20 @@ O = lynx.opt
 
 O.bg_color = {1, 1, 25, 255}
 
+-- Every input is resampled to this rate before analysis.
+O.analysis_rate = 44100
+
+-- Seconds of audio kept for lynx.api.get_history.
+O.history_seconds = 30
+
+-- Realtime mode: a priority from 1 to 99 puts audio and analysis threads on
+-- realtime scheduling and locks their buffers in memory. Cores of -1 leave
+-- threads unpinned. Needs rtprio and memlock limits (or root) to take effect.
+O.realtime_priority = 0
+O.audio_core = -1
+O.analysis_core = -1
+
+-- Set to 1 to print a warning for every frame that allocates once playback
+-- has settled. A summary of where memory went is printed on exit either way.
+O.alloc_check = 0
+
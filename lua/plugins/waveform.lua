@@ -3,8 +3,8 @@
 A = lynx.api
 
 S = {
-    vertices = {},
-    indices = {},
+    points = {},
+    coords = {},
     screen_size = {},
 }
 
@@ -31,7 +31,7 @@ end)
 local red_waveform_proc = A.proc.add("_3", function()
     A.bind_shader(0, "red.fs")
 
-    A.renderer.draw_lined_poly(S.vertices, S.indices, {255, 255, 255, 255})
+    A.renderer.draw_polyline(S.points, {255, 255, 255, 255}, S.coords)
 
     A.unbind_shader()
 end)
@@ -41,11 +41,22 @@ A.on_update(function()
 
     local samples = A.get_samples()
 
-    for i = 1, S.screen_size.x do
+    local width = A.param.get(wave_width)
+    local count = math.min(S.screen_size.x, #samples)
+
+    for i = 1, count do
         local y = i - 1
+        local sample = samples[#samples - i + 1]
+
+        S.points[2*i - 1] = y*width
+        S.points[2*i] = sample*S.screen_size.y/2 + S.screen_size.y/2
+        S.coords[2*i - 1] = y
+        S.coords[2*i] = sample
+    end
 
-        S.vertices[i] = {y*A.param.get(wave_width), samples[#samples - i + 1]*S.screen_size.y/2 + S.screen_size.y/2}
-        S.indices[i] = {y, samples[#samples - i + 1]}
+    for i = #S.points, 2*count + 1, -1 do
+        S.points[i] = nil
+        S.coords[i] = nil
     end
 end)
 
@@ -0,0 +1,252 @@
+#include "alloc.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "defines.h"
+#include "mutex.h"
+
+// Allocations carry their size in front, so frees can be accounted for.
+#define ALLOC_HEADER_SIZE 16
+
+static AllocCounter heap[AllocTag_COUNT] = {
+    [AllocTag_HASHMAP] = {.name = "hashmap"},
+    [AllocTag_SERVER] = {.name = "server"},
+    [AllocTag_DECODER] = {.name = "decoder"},
+    [AllocTag_PARAMETER] = {.name = "parameter"},
+};
+
+static struct {
+    Mutex        mutex;
+    B8           ready;
+    AllocCounter counters[ALLOC_MAX_ARENA_TAGS];
+    U32          count;
+} arena;
+
+static struct {
+    B8  checking;
+    U64 frames;
+    U64 settled;
+    U32 flagged;
+
+    _Atomic U32 allocations;
+} frame;
+
+// Only the thread running frames counts towards them. Decoders opening on
+// loader threads, say, don't make a frame any less steady.
+static _Thread_local B8 frame_thread;
+
+static void
+Count(AllocCounter *counter, U64 bytes, I64 live) {
+    atomic_fetch_add(&counter->count, 1);
+    atomic_fetch_add(&counter->bytes, bytes);
+    atomic_fetch_add(&counter->live, live);
+
+    if (frame_thread) {
+        atomic_fetch_add(&counter->frame, 1);
+        atomic_fetch_add(&frame.allocations, 1);
+    }
+}
+
+void *
+AllocMalloc(AllocTag tag, U64 size) {
+    U8 *data = malloc(ALLOC_HEADER_SIZE + size);
+
+    if (!data) {
+        return NULL;
+    }
+
+    *(U64 *)data = size;
+    Count(&heap[tag], size, size);
+
+    return data + ALLOC_HEADER_SIZE;
+}
+
+void *
+AllocCalloc(AllocTag tag, U64 count, U64 size) {
+    void *data = AllocMalloc(tag, count * size);
+
+    if (data) {
+        memset(data, 0, count * size);
+    }
+
+    return data;
+}
+
+void *
+AllocRealloc(AllocTag tag, void *data, U64 size) {
+    if (!data) {
+        return AllocMalloc(tag, size);
+    }
+
+    U8 *base = (U8 *)data - ALLOC_HEADER_SIZE;
+    U64 previous = *(U64 *)base;
+
+    base = realloc(base, ALLOC_HEADER_SIZE + size);
+
+    if (!base) {
+        return NULL;
+    }
+
+    *(U64 *)base = size;
+    Count(&heap[tag], size, (I64)size - (I64)previous);
+
+    return base + ALLOC_HEADER_SIZE;
+}
+
+void
+AllocFree(AllocTag tag, void *data) {
+    if (!data) {
+        return;
+    }
+
+    U8 *base = (U8 *)data - ALLOC_HEADER_SIZE;
+
+    atomic_fetch_sub(&heap[tag].live, *(U64 *)base);
+
+    free(base);
+}
+
+void *
+AllocHashmapMalloc(U32 size) {
+    return AllocMalloc(AllocTag_HASHMAP, size);
+}
+
+void *
+AllocHashmapRealloc(void *data, U32 size) {
+    return AllocRealloc(AllocTag_HASHMAP, data, size);
+}
+
+void
+AllocHashmapFree(void *data) {
+    AllocFree(AllocTag_HASHMAP, data);
+}
+
+// Called by the arena for every push onto a permanent arena. file names the
+// subsystem that pushed.
+void
+AllocCountPush(const char *file, U64 size) {
+    // Arenas are set up before anything else runs, so this is the first call.
+    if (!arena.ready) {
+        MutexCreate(&arena.mutex);
+        arena.ready = true;
+    }
+
+    MutexLock(&arena.mutex);
+
+    AllocCounter *counter = NULL;
+
+    for (U32 i = 0; i < arena.count; ++i) {
+        if (arena.counters[i].name == file ||
+            strcmp(arena.counters[i].name, file) == 0) {
+            counter = &arena.counters[i];
+            break;
+        }
+    }
+
+    if (!counter && arena.count < ALLOC_MAX_ARENA_TAGS) {
+        // Named before it is counted in, as frames read the list unlocked.
+        counter = &arena.counters[arena.count];
+        counter->name = file;
+        arena.count++;
+    }
+
+    MutexUnlock(&arena.mutex);
+
+    if (counter) {
+        // Arena memory is never given back.
+        Count(counter, size, size);
+    } else if (frame_thread) {
+        atomic_fetch_add(&frame.allocations, 1);
+    }
+}
+
+// Flags every allocation made in a steady-state frame.
+void
+AllocSetChecking(B8 checking) {
+    frame.checking = checking;
+}
+
+// Starts the warm-up again, for moments allocation is expected such as a new
+// track being loaded.
+void
+AllocSettle() {
+    frame.settled = frame.frames;
+}
+
+void
+AllocFrameBegin() {
+    frame_thread = true;
+
+    atomic_store(&frame.allocations, 0);
+
+    for (U32 i = 0; i < AllocTag_COUNT; ++i) {
+        atomic_store(&heap[i].frame, 0);
+    }
+
+    for (U32 i = 0; i < arena.count; ++i) {
+        atomic_store(&arena.counters[i].frame, 0);
+    }
+}
+
+static void
+PrintFrame(AllocCounter *counters, U32 count) {
+    for (U32 i = 0; i < count; ++i) {
+        U32 allocations = atomic_load(&counters[i].frame);
+
+        if (allocations > 0) {
+            printf(" %s x%u", counters[i].name, allocations);
+        }
+    }
+}
+
+// Returns the number of allocations the frame made.
+U32
+AllocFrameEnd() {
+    U32 allocations = atomic_load(&frame.allocations);
+
+    frame.frames++;
+
+    if (!frame.checking || allocations == 0 ||
+        frame.frames - frame.settled <= ALLOC_WARMUP_FRAMES) {
+        return allocations;
+    }
+
+    frame.flagged++;
+
+    if (frame.flagged <= ALLOC_MAX_FLAGGED) {
+        printf("WARNING: %u allocations in steady-state frame %llu:",
+               allocations, (unsigned long long)frame.frames);
+        PrintFrame(heap, AllocTag_COUNT);
+        PrintFrame(arena.counters, arena.count);
+        printf("\n");
+    }
+
+    return allocations;
+}
+
+static void
+PrintCounters(const char *title, AllocCounter *counters, U32 count) {
+    printf("%s\n", title);
+
+    for (U32 i = 0; i < count; ++i) {
+        printf("  %-24s %8llu allocations %10.1f KB total %10.1f KB live\n",
+               counters[i].name,
+               (unsigned long long)atomic_load(&counters[i].count),
+               atomic_load(&counters[i].bytes) / 1024.0,
+               atomic_load(&counters[i].live) / 1024.0);
+    }
+}
+
+void
+AllocReport() {
+    PrintCounters("Heap:", heap, AllocTag_COUNT);
+    PrintCounters("Permanent arena:", arena.counters, arena.count);
+
+    if (frame.checking) {
+        printf("%u of %llu frames allocated after warming up\n", frame.flagged,
+               (unsigned long long)frame.frames);
+    }
+}
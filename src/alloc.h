@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "defines.h"
+
+// Heap allocations made outside the arenas, by owner.
+typedef enum AllocTag {
+    AllocTag_HASHMAP = 0,
+    AllocTag_SERVER,
+    AllocTag_DECODER,
+    AllocTag_PARAMETER,
+    AllocTag_COUNT,
+} AllocTag;
+
+// Source files that can push onto the permanent arena.
+#define ALLOC_MAX_ARENA_TAGS 64
+
+// Frames after startup or AllocSettle before allocations are flagged.
+#define ALLOC_WARMUP_FRAMES 300
+
+// Flagged frames printed before the rest are only counted.
+#define ALLOC_MAX_FLAGGED 16
+
+typedef struct AllocCounter {
+    const char *name;
+
+    _Atomic U64 count;
+    _Atomic U64 bytes;
+    _Atomic I64 live;
+
+    // Made by the frame thread since AllocFrameBegin.
+    _Atomic U32 frame;
+} AllocCounter;
+
+void *
+AllocMalloc(AllocTag tag, U64 size);
+void *
+AllocCalloc(AllocTag tag, U64 count, U64 size);
+void *
+AllocRealloc(AllocTag tag, void *data, U64 size);
+void
+AllocFree(AllocTag tag, void *data);
+
+// Matches the hashmap allocator signatures.
+void *
+AllocHashmapMalloc(U32 size);
+void *
+AllocHashmapRealloc(void *data, U32 size);
+void
+AllocHashmapFree(void *data);
+
+void
+AllocCountPush(const char *file, U64 size);
+
+void
+AllocSetChecking(B8 checking);
+void
+AllocSettle();
+void
+AllocFrameBegin();
+U32
+AllocFrameEnd();
+void
+AllocReport();
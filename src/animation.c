@@ -1,179 +1,183 @@
 #include "animation.h"
-#include "arena.h"
-#include "hashmap.h"
-#include "lmath.h"
-#include "raylib.h"
-#include <assert.h>
+
 #include <stdio.h>
-#include <stdlib.h>
 #include <string.h>
 
-static U64
-AnimationsHash(const void *item, U64 seed0, U64 seed1) {
-    _Animation *anim = (_Animation *)item;
+#include "defines.h"
+#include "lmath.h"
+#include "raylib.h"
 
-    return hashmap_sip(anim->name, strlen(anim->name), seed0, seed1);
-}
+#define SLOT_BITS 16
+#define SLOT_MASK ((1u << SLOT_BITS) - 1)
 
-static I32
-AnimationsCompare(const void *a, const void *b, void *udata) {
-    _Animation *anim_a = (_Animation *)a;
-    _Animation *anim_b = (_Animation *)b;
+// The handle for whatever currently occupies slot.
+AnimationHandle
+AnimationsHandle(Animations *anims, U32 slot) {
+    return ((AnimationHandle)anims->generation[slot] << SLOT_BITS) | slot;
+}
 
-    return strcmp(anim_a->name, anim_b->name);
+static void
+ReleaseUserData(Animations *anims, U32 slot) {
+    if (anims->release[slot]) {
+        anims->release[slot](anims->user_data[slot]);
+        anims->release[slot] = NULL;
+    }
 }
 
 static void
-AnimationsFree(void *item) {
-    _Animation *anim = (_Animation *)item;
+Release(Animations *anims, U32 slot) {
+    ReleaseUserData(anims, slot);
 
-    if (anim->user_data) {
-        free(anim->user_data);
+    anims->live[slot] = false;
+
+    // Skips 0 so that no handle is ever ANIMATION_NONE.
+    if (++anims->generation[slot] == 0) {
+        anims->generation[slot] = 1;
     }
 
-    free(anim->name);
-    free(anim);
+    anims->free[anims->free_count++] = slot;
+}
+
+void
+AnimationsInitialise(Animations *anims) {
+    memset(anims, 0, sizeof(Animations));
+
+    for (U32 i = 0; i < ANIMATION_CAPACITY; ++i) {
+        anims->generation[i] = 1;
+    }
 }
 
-HM_Hashmap *
-AnimationsCreate() {
-    return hashmap_new(sizeof(_Animation), 0, 0, 0, AnimationsHash,
-                       AnimationsCompare, AnimationsFree, NULL);
+static I32
+FindByName(Animations *anims, const char *name) {
+    for (U32 i = 0; i < anims->used; ++i) {
+        if (anims->live[i] &&
+            strncmp(anims->name[i], name, ANIMATION_NAME_SIZE - 1) == 0) {
+            return i;
+        }
+    }
+
+    return -1;
 }
 
 /**
- * @brief Adds an animation to the animations hashmap. Allocates user_data for
- * you.
+ * @brief Starts an animation. One already running under the same name is
+ * restarted in place, so handles to it stay valid.
  *
- * @param anims The animations hashmap.
+ * @param anims The animation pool.
  * @param name The name of the animation.
- * @param user_data The user data to pass to the animation update function.
- * @param user_data_size The size of the user data.
+ * @param user_data Copied into the pool and passed to update.
+ * @param user_data_size At most ANIMATION_USER_DATA_SIZE.
  * @param update The animation update function.
- * @param arena The arena to allocate the animation from.
- * @return Animation* The animation.
+ * @param release Called with the user data once it is no longer needed. May
+ * be NULL.
+ * @return AnimationHandle The animation, or ANIMATION_NONE if the pool is full.
  */
-_Animation *
-AnimationsAdd_(HM_Hashmap *anims,
-               const char *name,
-               void       *user_data,
-               U32         user_data_size,
-               void (*update)(_Animation *anim, void *user_data, F64 dt),
-               MemoryArena *arena) {
-    if (AnimationsExists(anims, name)) {
-        _Animation *anim = (_Animation *)hashmap_get(
-            anims, &(_Animation){.name = (char *)name});
-
-        anim->val = 0.0f;
-
-        hashmap_set(anims, anim);
+AnimationHandle
+AnimationsAdd_(Animations      *anims,
+               const char      *name,
+               void            *user_data,
+               U32              user_data_size,
+               AnimationUpdate  update,
+               AnimationRelease release) {
+    I32 slot = FindByName(anims, name);
+
+    if (slot >= 0) {
+        ReleaseUserData(anims, slot);
+    } else {
+        if (anims->free_count > 0) {
+            slot = anims->free[--anims->free_count];
+        } else if (anims->used < ANIMATION_CAPACITY) {
+            slot = anims->used++;
+        } else {
+            printf("WARNING: no room for animation %s\n", name);
+            return ANIMATION_NONE;
+        }
+
+        snprintf(anims->name[slot], ANIMATION_NAME_SIZE, "%s", name);
     }
 
-    _Animation *anim = malloc(sizeof(_Animation));
-    memset(anim, 0, sizeof(_Animation));
-    anim->update = update;
+    anims->elapsed[slot] = 0.0;
+    anims->val[slot] = 0.0;
+    anims->finished[slot] = false;
+    anims->live[slot] = true;
+    anims->update[slot] = update;
+    anims->release[slot] = release;
+
+    memset(anims->user_data[slot], 0, ANIMATION_USER_DATA_SIZE);
 
     if (user_data) {
-        anim->user_data = malloc(user_data_size);
-        memcpy(anim->user_data, user_data, user_data_size);
+        memcpy(anims->user_data[slot], user_data,
+               MinU32(user_data_size, ANIMATION_USER_DATA_SIZE));
     }
 
-    anim->name = calloc(strlen(name) + 1, sizeof(char));
-    strcpy(anim->name, name);
-
-    hashmap_set(anims, anim);
-
-    return anim;
+    return AnimationsHandle(anims, slot);
 }
 
+// Animations that finished last frame are released here, before the rest
+// are stepped.
 void
-AnimationsUpdate(HM_Hashmap *anims) {
-    U32         i;
-    _Animation *anim;
+AnimationsUpdate(Animations *anims) {
+    F64 dt = GetFrameTime();
 
-    while (hashmap_iter(anims, &i, (void **)&anim)) {
-        if (anim->finished) {
-            AnimationsDelete(anims, anim->name);
+    for (U32 i = 0; i < anims->used; ++i) {
+        if (!anims->live[i]) {
             continue;
         }
 
-        anim->elapsed += GetFrameTime();
-        anim->update(anim, anim->user_data, GetFrameTime());
-        anim->val = ClampF32(anim->val, 0.0f, 1.0f);
+        if (anims->finished[i]) {
+            Release(anims, i);
+            continue;
+        }
+
+        anims->elapsed[i] += dt;
+        anims->update[i](anims, i, anims->user_data[i], dt);
+        anims->val[i] = ClampF32(anims->val[i], 0.0f, 1.0f);
     }
 }
 
-B8
-AnimationsExists(HM_Hashmap *anims, const char *name) {
-    _Animation *anim =
-        (_Animation *)hashmap_get(anims, &(_Animation){.name = (char *)name});
-
-    return anim != NULL;
-}
+void
+AnimationsDelete(Animations *anims, AnimationHandle handle) {
+    I32 slot = AnimationsResolve(anims, handle);
 
-B8
-AnimationsExists_(HM_Hashmap *anims, _Animation *anim) {
-    if (anim) {
-        return AnimationsExists(anims, anim->name);
+    if (slot >= 0) {
+        Release(anims, slot);
     }
-
-    return NULL;
 }
 
-F32
-AnimationsLoad(HM_Hashmap *anims, const char *name) {
-    if (!name) {
-        return 1.0f;
-    }
-
-    _Animation *anim =
-        (_Animation *)hashmap_get(anims, &(_Animation){.name = (char *)name});
+// Returns the slot handle refers to, or -1 if its animation has ended.
+I32
+AnimationsResolve(Animations *anims, AnimationHandle handle) {
+    U32 slot = handle & SLOT_MASK;
 
-    if (anim) {
-        return anim->val;
+    if (handle == ANIMATION_NONE || slot >= anims->used ||
+        !anims->live[slot] || AnimationsHandle(anims, slot) != handle) {
+        return -1;
     }
 
-    return 1.0f;
+    return slot;
 }
 
-F32
-AnimationsLoad_(HM_Hashmap *anims, _Animation *anim) {
-    if (anim) {
-        return AnimationsLoad(anims, anim->name);
-    }
-
-    return 1.0f;
+B8
+AnimationsExists(Animations *anims, AnimationHandle handle) {
+    return AnimationsResolve(anims, handle) >= 0;
 }
 
 F32
-AnimationsLoadEx(HM_Hashmap *anims, _Animation *anim_in) {
-    _Animation *anim = (_Animation *)hashmap_get(
-        anims, &(_Animation){.name = (char *)anim_in->name});
+AnimationsLoad(Animations *anims, AnimationHandle handle) {
+    I32 slot = AnimationsResolve(anims, handle);
 
-    if (anim) {
-        return anim->val;
+    if (slot >= 0) {
+        return anims->val[slot];
     }
 
     return 1.0f;
 }
 
 void
-AnimationsDelete(HM_Hashmap *anims, char *name) {
-    hashmap_delete(anims, &(_Animation){.name = name});
-}
-
-void
-AnimationsApply(HM_Hashmap *anims, char *name, F64 *val) {
-    if (AnimationsExists(anims, name)) {
-        *val = AnimationsLoad(anims, name);
-    }
-}
+AnimationsApply(Animations *anims, AnimationHandle handle, F64 *val) {
+    I32 slot = AnimationsResolve(anims, handle);
 
-void
-AnimationsApply_(HM_Hashmap *anims, _Animation anim) {
-    if (anim.name) {
-        AnimationsApply(anims, anim.name, &anim.val);
-    } else {
-        assert(0 && "Received NULL Animation");
+    if (slot >= 0) {
+        *val = anims->val[slot];
     }
 }
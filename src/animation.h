@@ -1,53 +1,82 @@
 #pragma once
 
-#include "arena.h"
 #include "defines.h"
-#include "hashmap.h"
 
-typedef struct _Animation {
-    F64   elapsed;
-    F64   val;
-    char *name;
+#define ANIMATION_CAPACITY 512
+#define ANIMATION_NAME_SIZE 64
 
-    void *user_data;
+// Largest user data an animation can carry; it is copied into the pool.
+#define ANIMATION_USER_DATA_SIZE 16
 
-    void (*update)(struct _Animation *anim, void *user_data, F64 dt);
+// Slot index in the low half, and the slot's generation when the handle was
+// given out in the high half. A handle goes stale once its animation ends,
+// even if the slot is reused. 0 is never a live handle.
+typedef U32 AnimationHandle;
 
-    B8 finished;
-} _Animation;
+#define ANIMATION_NONE ((AnimationHandle)0)
 
-HM_Hashmap *
-AnimationsCreate();
+typedef struct Animations Animations;
 
-void
-AnimationsUpdate(HM_Hashmap *anims);
+// Called once a frame for each running animation, which is anims' slot.
+typedef void (*AnimationUpdate)(Animations *anims,
+                                U32         slot,
+                                void       *user_data,
+                                F64         dt);
 
-#define AnimationsAdd(anims, name, user_data, update, arena)                   \
-    AnimationsAdd_((anims), (name), (void *)(user_data), sizeof(*(user_data)), \
-                   (update), (arena))
+// Called with an animation's user data when it ends, or when it is restarted
+// and its user data is about to be replaced.
+typedef void (*AnimationRelease)(void *user_data);
 
-_Animation *
-AnimationsAdd_(HM_Hashmap *anims,
-               const char *name,
-               void       *user_data,
-               U32         user_data_size,
-               void (*update)(_Animation *anim, void *user_data, F64 dt),
-               MemoryArena *arena);
+// Fixed pool of animations. Per-frame state is kept in parallel arrays and
+// walked in one pass; starting or finishing an animation never allocates.
+typedef struct Animations {
+    F64 elapsed[ANIMATION_CAPACITY];
+    F64 val[ANIMATION_CAPACITY];
+    B8  finished[ANIMATION_CAPACITY];
+    B8  live[ANIMATION_CAPACITY];
 
-void
-AnimationsDelete(HM_Hashmap *anims, char *name);
+    // Slots below this have been used at some point; the rest never have.
+    U32 used;
 
-F32
-AnimationsLoad(HM_Hashmap *anims, const char *name);
+    AnimationUpdate  update[ANIMATION_CAPACITY];
+    AnimationRelease release[ANIMATION_CAPACITY];
+    U16              generation[ANIMATION_CAPACITY];
+    U8   user_data[ANIMATION_CAPACITY][ANIMATION_USER_DATA_SIZE];
+    char name[ANIMATION_CAPACITY][ANIMATION_NAME_SIZE];
 
-F32
-AnimationsLoad_(HM_Hashmap *anims, _Animation *anim);
+    U32 free[ANIMATION_CAPACITY];
+    U32 free_count;
+} Animations;
 
-B8
-AnimationsExists(HM_Hashmap *anims, const char *name);
+#define AnimationsAdd(anims, name, user_data, update)                          \
+    AnimationsAdd_((anims), (name), (void *)(user_data), sizeof(*(user_data)), \
+                   (update), NULL)
+#define AnimationsAddWithRelease(anims, name, user_data, update, release)      \
+    AnimationsAdd_((anims), (name), (void *)(user_data), sizeof(*(user_data)), \
+                   (update), (release))
 
-B8
-AnimationsExists_(HM_Hashmap *anims, _Animation *anim);
+void
+AnimationsInitialise(Animations *anims);
+void
+AnimationsUpdate(Animations *anims);
 
+AnimationHandle
+AnimationsAdd_(Animations      *anims,
+               const char      *name,
+               void            *user_data,
+               U32              user_data_size,
+               AnimationUpdate  update,
+               AnimationRelease release);
+void
+AnimationsDelete(Animations *anims, AnimationHandle handle);
+
+AnimationHandle
+AnimationsHandle(Animations *anims, U32 slot);
+I32
+AnimationsResolve(Animations *anims, AnimationHandle handle);
+B8
+AnimationsExists(Animations *anims, AnimationHandle handle);
+F32
+AnimationsLoad(Animations *anims, AnimationHandle handle);
 void
-AnimationsApply(HM_Hashmap *anims, char *name, F64 *val);
+AnimationsApply(Animations *anims, AnimationHandle handle, F64 *val);
@@ -1,11 +1,13 @@
 #include "api.h"
 
+#include "alloc.h"
 #include "animation.h"
 #include "arena.h"
 #include "defines.h"
 #include "filesystem.h"
 #include "handmademath.h"
 #include "hashmap.h"
+#include "intern.h"
 #include "lmath.h"
 #include "lua.h"
 #include "procedures.h"
@@ -56,18 +58,15 @@ PopApi(ApiData *api);
 static int
 RegisterCallback(lua_State *L);
 
-#define CallCallback(L, callback, args)                                        \
-    if (!CallCallback_((L), (callback), (args))) {                             \
-        printf("Error calling callback in %s: %s\n", #callback,                \
-               lua_tostring(L, -1));                                           \
-    }
-
-static B8
-CallCallback_(lua_State *L, int *callback, U32 args);
+static void
+CallCallback(lua_State *L, ApiCallback callback, U32 args);
 
 static void
 FreeCallback(lua_State *L, int *callback);
 
+static void
+CreateFloatBuffers(ApiData *api);
+
 static void
 DumpStack(lua_State *L) {
     int top = lua_gettop(L);
@@ -99,6 +98,7 @@ API_METHODS_ANIMATION
 API_METHODS_RENDERER
 API_METHODS_PROCS
 API_METHODS_PARAMS
+API_METHODS_STEMS
 #undef X
 
 static void
@@ -119,16 +119,25 @@ SetPath(lua_State *L, const char *path) {
 }
 
 static U64
-ApiShaderHash(const void *item, U64 seed0, U64 seed1) {
-    ApiShader *pshader = (ApiShader *)item;
+InternHashOrZero(Intern string) {
+    return string ? string->hash : 0;
+}
 
-    char buf[512];
+static U64
+ApiShaderHash(const ApiShader *shader) {
+    return InternHashOrZero(shader->vertex) * 31 +
+           InternHashOrZero(shader->fragment);
+}
 
-    snprintf(buf, 512, "%s%s", pshader->vertex, pshader->fragment);
+static U64
+ApiShaderHashItem(const void *item, U64 seed0, U64 seed1) {
+    (void)(seed0);
+    (void)(seed1);
 
-    return hashmap_sip(buf, strlen(buf), seed0, seed1);
+    return ApiShaderHash((ApiShader *)item);
 }
 
+// Paths are interned, so comparing pointers is enough.
 static I32
 ApiShaderCompare(const void *a, const void *b, void *udata) {
     (void)(udata);
@@ -136,13 +145,7 @@ ApiShaderCompare(const void *a, const void *b, void *udata) {
     ApiShader *pa = (ApiShader *)a;
     ApiShader *pb = (ApiShader *)b;
 
-    char bufa[512];
-    snprintf(bufa, 512, "%s%s", pa->vertex, pa->fragment);
-
-    char bufb[512];
-    snprintf(bufb, 512, "%s%s", pb->vertex, pb->fragment);
-
-    return strcmp(bufa, bufb);
+    return pa->vertex != pb->vertex || pa->fragment != pb->fragment;
 }
 
 static void
@@ -157,10 +160,20 @@ ApiInitialise(const char *api_fp, void *state, ApiData *api) {
     api->lua = luaL_newstate();
     luaL_openlibs(api->lua);
 
-    api->shaders = hashmap_new(sizeof(ApiShader), 0, 0, 0, ApiShaderHash,
-                               ApiShaderCompare, ApiShaderFree, NULL);
+    api->shaders = hashmap_new_with_allocator(
+        AllocHashmapMalloc, AllocHashmapRealloc, AllocHashmapFree,
+        sizeof(ApiShader), 0, 0, 0, ApiShaderHashItem, ApiShaderCompare,
+        ApiShaderFree, NULL);
+
+    api->data.opt.analysis_rate = ANALYSIS_SAMPLE_RATE;
+    api->data.opt.history_seconds = HISTORY_SECONDS;
+    api->data.opt.realtime_priority = 0;
+    api->data.opt.audio_core = -1;
+    api->data.opt.analysis_core = -1;
+    api->data.opt.alloc_check = false;
 
     PushApi(api);
+    CreateFloatBuffers(api);
 
     // Set the path to lua
     {
@@ -192,7 +205,7 @@ ApiPreUpdate(ApiData *api, void *state) {
 
     for (U32 i = 0; i < api->pre_update_count; ++i) {
         if (api->pre_update[i] != -1) {
-            CallCallback(api->lua, &api->pre_update[i], 0);
+            CallCallback(api->lua, api->pre_update[i], 0);
         }
     }
 }
@@ -203,7 +216,7 @@ ApiUpdate(ApiData *api, void *state) {
 
     for (U32 i = 0; i < api->on_update_count; ++i) {
         if (api->on_update[i] != -1) {
-            CallCallback(api->lua, &api->on_update[i], 0);
+            CallCallback(api->lua, api->on_update[i], 0);
         }
     }
 }
@@ -214,7 +227,7 @@ ApiPreRender(ApiData *api, void *state) {
 
     for (U32 i = 0; i < api->pre_render_count; ++i) {
         if (api->pre_render[i] != -1) {
-            CallCallback(api->lua, &api->pre_render[i], 0);
+            CallCallback(api->lua, api->pre_render[i], 0);
         }
     }
 }
@@ -225,7 +238,7 @@ ApiRender(ApiData *api, void *state) {
 
     for (U32 i = 0; i < api->on_render_count; ++i) {
         if (api->on_render[i] != -1) {
-            CallCallback(api->lua, &api->on_render[i], 0);
+            CallCallback(api->lua, api->on_render[i], 0);
         }
     }
 }
@@ -271,6 +284,30 @@ PushApi(ApiData *api) {
             lua_pushstring(api->lua, "bg_color");
             PushColor(api->lua, api->data.opt.bg_color);
             lua_settable(api->lua, -3);
+
+            lua_pushstring(api->lua, "analysis_rate");
+            lua_pushnumber(api->lua, api->data.opt.analysis_rate);
+            lua_settable(api->lua, -3);
+
+            lua_pushstring(api->lua, "history_seconds");
+            lua_pushnumber(api->lua, api->data.opt.history_seconds);
+            lua_settable(api->lua, -3);
+
+            lua_pushstring(api->lua, "realtime_priority");
+            lua_pushnumber(api->lua, api->data.opt.realtime_priority);
+            lua_settable(api->lua, -3);
+
+            lua_pushstring(api->lua, "audio_core");
+            lua_pushnumber(api->lua, api->data.opt.audio_core);
+            lua_settable(api->lua, -3);
+
+            lua_pushstring(api->lua, "analysis_core");
+            lua_pushnumber(api->lua, api->data.opt.analysis_core);
+            lua_settable(api->lua, -3);
+
+            lua_pushstring(api->lua, "alloc_check");
+            lua_pushnumber(api->lua, api->data.opt.alloc_check);
+            lua_settable(api->lua, -3);
         }
         lua_settable(api->lua, -3);
 
@@ -291,6 +328,7 @@ PushApi(ApiData *api) {
             NSPACE(renderer, API_METHODS_RENDERER)
             NSPACE(proc, API_METHODS_PROCS)
             NSPACE(param, API_METHODS_PARAMS)
+            NSPACE(stem, API_METHODS_STEMS)
 #undef NSPACE
 
 #undef X
@@ -302,13 +340,16 @@ PushApi(ApiData *api) {
 
 Color
 PopColor(lua_State *L) {
+    // The value is popped on every path, so callers stay balanced.
     if (!lua_istable(L, -1)) {
         ApiError(L, "tried parsing non-table color");
+        lua_pop(L, 1);
         return (Color){0};
     }
 
     if (luaL_len(L, -1) != 4) {
         ApiError(L, "tried parsing non-four sized color");
+        lua_pop(L, 1);
         return (Color){0};
     }
 
@@ -355,6 +396,19 @@ PushColor(lua_State *L, Color c) {
     }
 }
 
+// Reads field name of the table at the top of the stack, falling back to def
+// when a script leaves it unset.
+static F64
+PopOptionalNumber(lua_State *L, const char *name, F64 def) {
+    lua_getfield(L, -1, name);
+
+    F64 value = lua_isnumber(L, -1) ? lua_tonumber(L, -1) : def;
+
+    lua_pop(L, 1);
+
+    return value;
+}
+
 ApiInterface
 PopApi(ApiData *api) {
     ApiInterface data;
@@ -367,6 +421,23 @@ PopApi(ApiData *api) {
             lua_pushstring(api->lua, "bg_color");
             lua_gettable(api->lua, -2);
             data.opt.bg_color = PopColor(api->lua);
+
+            data.opt.analysis_rate = PopOptionalNumber(
+                api->lua, "analysis_rate", api->data.opt.analysis_rate);
+
+            data.opt.history_seconds = PopOptionalNumber(
+                api->lua, "history_seconds", api->data.opt.history_seconds);
+
+            data.opt.realtime_priority =
+                PopOptionalNumber(api->lua, "realtime_priority",
+                                  api->data.opt.realtime_priority);
+            data.opt.audio_core = PopOptionalNumber(api->lua, "audio_core",
+                                                    api->data.opt.audio_core);
+            data.opt.analysis_core = PopOptionalNumber(
+                api->lua, "analysis_core", api->data.opt.analysis_core);
+
+            data.opt.alloc_check = PopOptionalNumber(
+                api->lua, "alloc_check", api->data.opt.alloc_check);
         }
         lua_pop(api->lua, 1);
     }
@@ -380,28 +451,93 @@ RegisterCallback(lua_State *L) {
     return luaL_ref(L, LUA_REGISTRYINDEX);
 }
 
-B8
-CallCallback_(lua_State *L, ApiCallback *callback, U32 args) {
-    lua_rawgeti(L, LUA_REGISTRYINDEX, *callback);
+// Prints msg unless the same message was printed less than
+// API_ERROR_INTERVAL seconds ago. Repeats in between are only counted, and
+// the count is printed with the next report. Returns whether msg was printed.
+static B8
+ReportError(const char *msg, const char *traceback) {
+    ApiData *api = p_state->api_data;
 
-    lua_pushvalue(L, -1);
+    U64 hash = hashmap_xxhash3(msg, strlen(msg), 0, 0);
+    F64 now = GetTime();
 
-    // Replicate while moving function behind arguments.
-    for (U32 i = 0; i < args; ++i) {
-        lua_pushvalue(L, -args - 2);
-    }
+    ApiErrorLog *log = &api->errors[hash % API_ERROR_SLOTS];
 
-    if (lua_pcall(L, args, 0, 0) != 0) {
+    if (log->hash == hash && now - log->reported < API_ERROR_INTERVAL) {
+        log->suppressed++;
         return false;
     }
 
-    *callback = luaL_ref(L, LUA_REGISTRYINDEX);
+    if (log->hash == hash && log->suppressed > 0) {
+        printf("Error calling lua (repeated %u more times): %s\n",
+               log->suppressed, msg);
+    } else {
+        printf("Error calling lua: %s\n", msg);
+    }
+
+    if (traceback) {
+        printf("%s\n", traceback);
+    }
 
-    lua_pop(L, args);
+    log->hash = hash;
+    log->reported = now;
+    log->suppressed = 0;
 
     return true;
 }
 
+// Message handler for every callback. It runs before the stack unwinds, so
+// the traceback still points at the error, and it is only built when the
+// error is going to be printed.
+static int
+MessageHandler(lua_State *L) {
+    const char *msg = lua_tostring(L, 1);
+
+    if (!msg) {
+        msg = lua_pushfstring(L, "(error object is a %s value)",
+                              luaL_typename(L, 1));
+    }
+
+    if (ReportError(msg, NULL)) {
+        luaL_traceback(L, L, NULL, 1);
+        printf("%s\n", lua_tostring(L, -1));
+    }
+
+    return 1;
+}
+
+// Calls the callback with the args on top of the stack, and pops them.
+// Errors are reported through MessageHandler, so the callback is never
+// re-fetched or re-referenced.
+void
+CallCallback(lua_State *L, ApiCallback callback, U32 args) {
+    I32 base = lua_gettop(L) - args + 1;
+
+    lua_pushcfunction(L, MessageHandler);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, callback);
+
+    // Move the handler and function behind the arguments.
+    lua_rotate(L, base, 2);
+
+    lua_pcall(L, args, 0, base);
+
+    // Pops the handler, and the error if there was one.
+    lua_settop(L, base - 1);
+}
+
+// Keeps the function at the top of the stack in list, which the dispatch
+// loops walk every frame.
+static void
+AddCallback(lua_State *L, ApiCallback *list, U32 *count) {
+    if (*count >= MAX_API_CALLBACKS) {
+        ApiError(L, "tried registering too many callbacks");
+        lua_pop(L, 1);
+        return;
+    }
+
+    list[(*count)++] = RegisterCallback(L);
+}
+
 void
 FreeCallback(lua_State *L, ApiCallback *callback) {
     luaL_unref(L, LUA_REGISTRYINDEX, *callback);
@@ -413,7 +549,7 @@ static int
 L_GetMusicTimePlayed(lua_State *L) {
     F32 time_played = p_state->condition == StateCondition_RECORDING
                           ? GetTime() - p_state->record_start
-                          : GetMusicTimePlayed(p_state->music);
+                          : PlayerTimePlayed(p_state->player);
 
     lua_pushnumber(L, time_played);
 
@@ -432,42 +568,53 @@ L_AddParameter(lua_State *L) {
     F32         min = lua_tonumber(L, 3);
     F32         max = lua_tonumber(L, 4);
 
-    char *mem = ArenaPushString(&p_state->arena, name);
-
-    Parameter param = {
-        .name = mem,
-        .value = value,
-        .min = min,
-        .max = max,
-    };
+    // Reloading the script adds every parameter again, and gets back the
+    // handle it had before.
+    ParameterHandle handle =
+        ParameterRegister(p_state->parameters, name, value, min, max);
 
-    ParameterSet(p_state->parameters, &param);
+    if (handle == PARAMETER_NONE) {
+        ApiErrorFunction(L, add_param, "could not allocate the parameter");
+        return 0;
+    }
 
-    lua_pushlightuserdata(L, ParameterGet(p_state->parameters, name));
+    lua_pushinteger(L, handle);
 
     return 1;
 }
 
+// Parameters are usually passed by the handle add returned. Names still work,
+// at the cost of a lookup.
+static ParameterHandle
+ToParameter(lua_State *L, I32 index) {
+    if (lua_type(L, index) == LUA_TSTRING) {
+        return ParameterFind(p_state->parameters, lua_tostring(L, index));
+    }
+
+    return lua_tointeger(L, index);
+}
+
 static int
 L_SetParameter(lua_State *L) {
-    CheckArgument(L, LUA_TSTRING, 1, set_param);
+    if (lua_type(L, 1) != LUA_TSTRING) {
+        CheckArgument(L, LUA_TNUMBER, 1, set_param);
+    }
     CheckArgument(L, LUA_TNUMBER, 2, set_param);
 
-    const char *name = lua_tostring(L, 1);
-    F32         value = lua_tonumber(L, 2);
-
-    ParameterSetValue(p_state->parameters, name, value);
+    ParameterSetValue(p_state->parameters, ToParameter(L, 1),
+                      lua_tonumber(L, 2));
 
     return 0;
 }
 
 static int
 L_GetParameter(lua_State *L) {
-    CheckArgument(L, LUA_TLIGHTUSERDATA, 1, get_param);
-
-    Parameter *param = lua_touserdata(L, 1);
+    if (lua_type(L, 1) != LUA_TSTRING) {
+        CheckArgument(L, LUA_TNUMBER, 1, get_param);
+    }
 
-    lua_pushnumber(L, ParameterGetValue(p_state->parameters, param->name));
+    lua_pushnumber(L,
+                   ParameterGetValue(p_state->parameters, ToParameter(L, 1)));
 
     return 1;
 }
@@ -476,8 +623,8 @@ static int
 L_PreUpdate(lua_State *L) {
     CheckArgument(L, LUA_TFUNCTION, 1, pre_update);
 
-    p_state->api_data->pre_update[p_state->api_data->pre_update_count++] =
-        RegisterCallback(L);
+    AddCallback(L, p_state->api_data->pre_update,
+                &p_state->api_data->pre_update_count);
 
     return 0;
 }
@@ -486,8 +633,8 @@ static int
 L_OnUpdate(lua_State *L) {
     CheckArgument(L, LUA_TFUNCTION, 1, on_update);
 
-    p_state->api_data->on_update[p_state->api_data->on_update_count++] =
-        RegisterCallback(L);
+    AddCallback(L, p_state->api_data->on_update,
+                &p_state->api_data->on_update_count);
 
     return 0;
 }
@@ -496,8 +643,8 @@ static int
 L_OnRender(lua_State *L) {
     CheckArgument(L, LUA_TFUNCTION, 1, on_render);
 
-    p_state->api_data->on_render[p_state->api_data->on_render_count++] =
-        RegisterCallback(L);
+    AddCallback(L, p_state->api_data->on_render,
+                &p_state->api_data->on_render_count);
 
     return 0;
 }
@@ -506,8 +653,8 @@ static int
 L_PreRender(lua_State *L) {
     CheckArgument(L, LUA_TFUNCTION, 1, pre_render);
 
-    p_state->api_data->pre_render[p_state->api_data->pre_render_count++] =
-        RegisterCallback(L);
+    AddCallback(L, p_state->api_data->pre_render,
+                &p_state->api_data->pre_render_count);
 
     return 0;
 }
@@ -540,44 +687,258 @@ PushArray(lua_State *L, F32 *array, U32 count) {
 
 static void
 PopArray(lua_State *L, F32 *out, U32 count) {
-    F32 array[count];
-
     for (U32 i = 0; i < count; ++i) {
         lua_geti(L, -1, i + 1);
-        array[i] = lua_tonumber(L, -1);
+        out[i] = lua_tonumber(L, -1);
+        lua_pop(L, 1);
+    }
+}
+
+#define FLOAT_BUFFER "FloatBuffer"
+
+// A read-only view of an array owned by State, indexed from 1 like a table.
+// It reads the array as it is at the time, so scripts can keep hold of one
+// buffer instead of copying the array into a new table every frame.
+typedef struct FloatBuffer {
+    const F32 *data;
+    const U32 *count;
+} FloatBuffer;
+
+static const U32 sample_count = SAMPLE_COUNT;
+
+static int
+L_FloatBufferIndex(lua_State *L) {
+    FloatBuffer *buffer = luaL_checkudata(L, 1, FLOAT_BUFFER);
+
+    I32         is_integer;
+    lua_Integer i = lua_tointegerx(L, 2, &is_integer);
+
+    if (is_integer && i >= 1 && i <= *buffer->count) {
+        lua_pushnumber(L, buffer->data[i - 1]);
+    } else {
+        lua_pushnil(L);
+    }
+
+    return 1;
+}
+
+static int
+L_FloatBufferLen(lua_State *L) {
+    FloatBuffer *buffer = luaL_checkudata(L, 1, FLOAT_BUFFER);
+
+    lua_pushinteger(L, *buffer->count);
+
+    return 1;
+}
+
+static int
+L_FloatBufferNewIndex(lua_State *L) {
+    ApiError(L, "tried writing to a read-only FloatBuffer");
+
+    return 0;
+}
+
+// Leaves a new buffer over data on the stack and returns a registry
+// reference to it.
+static I32
+CreateFloatBuffer(lua_State *L, const F32 *data, const U32 *count) {
+    FloatBuffer *buffer = lua_newuserdatauv(L, sizeof(FloatBuffer), 0);
+
+    buffer->data = data;
+    buffer->count = count;
+
+    luaL_setmetatable(L, FLOAT_BUFFER);
+
+    return luaL_ref(L, LUA_REGISTRYINDEX);
+}
+
+static void
+CreateFloatBuffers(ApiData *api) {
+    static const luaL_Reg methods[] = {
+        {"__index", L_FloatBufferIndex},
+        {"__len", L_FloatBufferLen},
+        {"__newindex", L_FloatBufferNewIndex},
+        {NULL, NULL},
+    };
+
+    luaL_newmetatable(api->lua, FLOAT_BUFFER);
+    luaL_setfuncs(api->lua, methods, 0);
+    lua_pop(api->lua, 1);
+
+    api->samples =
+        CreateFloatBuffer(api->lua, p_state->samples, &sample_count);
+    api->frequencies = CreateFloatBuffer(api->lua, p_state->frequencies,
+                                         &p_state->frequency_count);
+}
+
+// Copies a table, or a FloatBuffer, at the top of the stack into out.
+static U32
+PopFloats(lua_State *L, F32 *out, U32 count) {
+    FloatBuffer *buffer = luaL_testudata(L, -1, FLOAT_BUFFER);
+
+    if (buffer) {
+        count = MinU32(count, *buffer->count);
+        memcpy(out, buffer->data, count * sizeof(F32));
+    } else {
+        PopArray(L, out, count);
+    }
+
+    return count;
+}
+
+// Reads a table, or a FloatBuffer, at index as a flat array of floats. A
+// FloatBuffer is used in place; a table is copied into the transient arena,
+// so call this inside a scratch scope. Returns NULL for anything else.
+static const F32 *
+ToFloats(lua_State *L, I32 index, U32 *count) {
+    FloatBuffer *buffer = luaL_testudata(L, index, FLOAT_BUFFER);
+
+    if (buffer) {
+        *count = *buffer->count;
+        return buffer->data;
+    }
+
+    if (lua_type(L, index) != LUA_TTABLE) {
+        return NULL;
+    }
+
+    *count = lua_rawlen(L, index);
+
+    F32 *out = ArenaPushArray(&p_state->transient, *count, F32);
+    for (U32 i = 0; i < *count; ++i) {
+        lua_rawgeti(L, index, i + 1);
+        out[i] = lua_tonumber(L, -1);
         lua_pop(L, 1);
     }
 
-    memcpy(out, array, sizeof(F32) * count);
+    return out;
 }
 
+// get_samples() returns a FloatBuffer over the analysis window for this
+// frame. It is the same buffer every call, and always shows the current
+// frame.
 static int
 L_GetSamples(lua_State *L) {
-    PushArray(L, p_state->samples, SAMPLE_COUNT);
+    lua_rawgeti(L, LUA_REGISTRYINDEX, p_state->api_data->samples);
+
+    return 1;
+}
+
+// get_frequencies() returns a FloatBuffer over the smoothed spectrum drawn
+// this frame. Its length follows the number of bars on screen.
+static int
+L_GetFrequencies(lua_State *L) {
+    lua_rawgeti(L, LUA_REGISTRYINDEX, p_state->api_data->frequencies);
+
+    return 1;
+}
+
+// get_history(count, [seconds]) returns count samples ending at the same
+// frame as get_samples. Without seconds they are consecutive; with it they are
+// spread evenly over the last seconds of audio.
+static int
+L_GetHistory(lua_State *L) {
+    CheckArgument(L, LUA_TNUMBER, 1, get_history);
+
+    History *history = p_state->history;
+
+    U32 count = ClampI32(lua_tonumber(L, 1), 0, HistoryCapacity(history));
+    U32 stride = 1;
+
+    if (lua_type(L, 2) == LUA_TNUMBER && count > 0) {
+        stride = lua_tonumber(L, 2) * history->rate / count;
+    }
+
+    ArenaTemp scratch = ArenaBeginTemp(&p_state->transient);
+    F32      *samples = ArenaPushArray(&p_state->transient, count, F32);
+
+    HistoryRead(history, p_state->analysis_end, samples, count, stride);
+    PushArray(L, samples, count);
+
+    ArenaEndTemp(scratch);
+
+    return 1;
+}
+
+// stem.load(name, path) plays path as the stem called name, in sync with the
+// current track. Returns false if there are already too many stems.
+static int
+L_LoadStem(lua_State *L) {
+    CheckArgument(L, LUA_TSTRING, 1, stem.load);
+    CheckArgument(L, LUA_TSTRING, 2, stem.load);
+
+    lua_pushboolean(
+        L, StemsLoad(p_state->stems, lua_tostring(L, 1), lua_tostring(L, 2)));
+
+    return 1;
+}
+
+static int
+L_ClearStems(lua_State *L) {
+    StemsClear(p_state->stems);
+
+    return 0;
+}
+
+static int
+L_GetStemSamples(lua_State *L) {
+    CheckArgument(L, LUA_TSTRING, 1, stem.get_samples);
+
+    Stem *stem = StemsFind(p_state->stems, lua_tostring(L, 1));
+
+    if (!stem) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    PushArray(L, stem->samples, SAMPLE_COUNT);
+
+    return 1;
+}
+
+static int
+L_GetStemFrequencies(lua_State *L) {
+    CheckArgument(L, LUA_TSTRING, 1, stem.get_frequencies);
+
+    Stem *stem = StemsFind(p_state->stems, lua_tostring(L, 1));
+
+    if (!stem) {
+        lua_pushnil(L);
+        return 1;
+    }
+
+    PushArray(L, stem->frequencies, stem->frequency_count);
 
     return 1;
 }
 
 static int
 L_SmoothSignal(lua_State *L) {
-    CheckArgument(L, LUA_TTABLE, 1, smooth_signal);
+    if (!luaL_testudata(L, 1, FLOAT_BUFFER)) {
+        CheckArgument(L, LUA_TTABLE, 1, smooth_signal);
+    }
+
+    lua_settop(L, 1);
 
     U32 length = luaL_len(L, 1);
 
-    F32 in[length];
+    ArenaTemp scratch = ArenaBeginTemp(&p_state->transient);
+    F32      *in = ArenaPushArray(&p_state->transient, length, F32);
 
-    PopArray(L, in, length);
+    length = PopFloats(L, in, length);
 
     U32 out_length;
     SignalsSmoothConvolve(NULL, length, NULL, p_state->filter_count, NULL,
                           &out_length);
 
-    F32 out[out_length];
+    F32 *out = ArenaPushArray(&p_state->transient, out_length, F32);
     SignalsSmoothConvolve(in, length, p_state->filter, p_state->filter_count,
                           out, &out_length);
 
     PushArray(L, out, out_length);
 
+    ArenaEndTemp(scratch);
+
     return 1;
 }
 
@@ -590,10 +951,12 @@ L_GetScreenSize(lua_State *L) {
 
 void
 ApiError(lua_State *L, const char *msg) {
-    luaL_traceback(L, L, NULL, 1);
-    printf("Error calling lua: %s\n%s\n", msg, lua_tostring(L, -1));
-    lua_pop(L, 1);
-    return;
+    // Only build the traceback when it is going to be printed.
+    if (ReportError(msg, NULL)) {
+        luaL_traceback(L, L, NULL, 1);
+        printf("%s\n", lua_tostring(L, -1));
+        lua_pop(L, 1);
+    }
 }
 
 static HMM_Vec2
@@ -651,14 +1014,18 @@ L_DrawLinedPoly(lua_State *L) {
 
     Color color = PopColor(L);
 
+    ArenaTemp scratch = ArenaBeginTemp(&p_state->transient);
+
     // Indices are at the top of the stack
-    HMM_Vec2 indices[index_count];
+    HMM_Vec2 *indices =
+        ArenaPushArray(&p_state->transient, index_count, HMM_Vec2);
     for (U32 i = 0; i < index_count; ++i) {
         lua_geti(L, -1, i + 1);
 
         if (!lua_istable(L, -1)) {
             ApiErrorFunction(L, draw_lined_poly,
                              "received non-two sized vector index");
+            ArenaEndTemp(scratch);
             return 0;
         }
 
@@ -667,13 +1034,15 @@ L_DrawLinedPoly(lua_State *L) {
     lua_pop(L, 1);
 
     // Vertices are now at the top of the stack
-    HMM_Vec2 vertices[vertex_count];
+    HMM_Vec2 *vertices =
+        ArenaPushArray(&p_state->transient, vertex_count, HMM_Vec2);
     for (U32 i = 0; i < vertex_count; ++i) {
         lua_geti(L, -1, i + 1);
 
         if (!lua_istable(L, -1)) {
             ApiErrorFunction(L, draw_lined_poly,
                              "received non-two sized vector vertex");
+            ArenaEndTemp(scratch);
             return 0;
         }
         vertices[i] = PopVec2(L);
@@ -682,6 +1051,100 @@ L_DrawLinedPoly(lua_State *L) {
     RendererDrawLinedPoly(p_state->renderer_data, vertices, vertex_count,
                           indices, index_count, color);
 
+    ArenaEndTemp(scratch);
+
+    return 0;
+}
+
+// Reads the color at index, leaving the stack as it was.
+static Color
+ToColor(lua_State *L, I32 index) {
+    lua_pushvalue(L, index);
+
+    return PopColor(L);
+}
+
+// The batch draws take a flat array of floats, either a table or a
+// FloatBuffer, and a color. Each shape is drawn in one pass without building
+// a table per vertex.
+#define DrawBatch(L, function, stride, draw)                                   \
+    do {                                                                       \
+        CheckArgument(L, LUA_TTABLE, 2, function);                             \
+                                                                               \
+        ArenaTemp scratch = ArenaBeginTemp(&p_state->transient);               \
+                                                                               \
+        U32        count;                                                      \
+        const F32 *data = ToFloats(L, 1, &count);                              \
+                                                                               \
+        if (data) {                                                            \
+            draw(p_state->renderer_data, data, count / (stride),               \
+                 ToColor(L, 2));                                               \
+        } else {                                                               \
+            ApiErrorFunction(L, function,                                      \
+                             "received non-array argument 1");                 \
+        }                                                                      \
+                                                                               \
+        ArenaEndTemp(scratch);                                                 \
+    } while (0)
+
+// draw_lines(points, color) draws a segment for every two x, y points.
+static int
+L_DrawLines(lua_State *L) {
+    DrawBatch(L, draw_lines, 2, RendererDrawLines);
+
+    return 0;
+}
+
+// draw_polyline(points, color, [texcoords]) joins the x, y points in order.
+// texcoords holds a u, v pair per point.
+static int
+L_DrawPolyline(lua_State *L) {
+    CheckArgument(L, LUA_TTABLE, 2, draw_polyline);
+
+    ArenaTemp scratch = ArenaBeginTemp(&p_state->transient);
+
+    U32        count, coord_count = 0;
+    const F32 *points = ToFloats(L, 1, &count);
+    const F32 *coords = lua_isnoneornil(L, 3) ? NULL
+                                              : ToFloats(L, 3, &coord_count);
+
+    if (!points) {
+        ApiErrorFunction(L, draw_polyline, "received non-array argument 1");
+    } else if (coords && coord_count < count) {
+        ApiErrorFunction(L, draw_polyline,
+                         "received fewer texcoords than points");
+    } else {
+        RendererDrawPolyline(p_state->renderer_data, points, coords, count / 2,
+                             ToColor(L, 2));
+    }
+
+    ArenaEndTemp(scratch);
+
+    return 0;
+}
+
+// draw_polygon(points, color) fills the convex polygon through the x, y
+// points.
+static int
+L_DrawPolygon(lua_State *L) {
+    DrawBatch(L, draw_polygon, 2, RendererDrawPolygon);
+
+    return 0;
+}
+
+// draw_rects(rects, color) fills a rectangle for every x, y, width, height.
+static int
+L_DrawRects(lua_State *L) {
+    DrawBatch(L, draw_rects, 4, RendererDrawRects);
+
+    return 0;
+}
+
+// draw_circles(circles, color) fills a circle for every x, y, radius.
+static int
+L_DrawCircles(lua_State *L) {
+    DrawBatch(L, draw_circles, 3, RendererDrawCircles);
+
     return 0;
 }
 
@@ -721,20 +1184,22 @@ L_BindShader(lua_State *L) {
                                      lua_tostring(p_state->api_data->lua, 2));
     }
 
-    ApiShader seek = {};
-
-    strcpy(seek.fragment, fragment_shader);
-    strcpy(seek.vertex, vertex_shader);
+    ApiShader seek = {
+        .vertex = vertex_shader ? InternGet(vertex_shader) : NULL,
+        .fragment = fragment_shader ? InternGet(fragment_shader) : NULL,
+    };
+    U64 hash = ApiShaderHash(&seek);
 
-    ApiShader *shad =
-        (ApiShader *)hashmap_get(p_state->api_data->shaders, &seek);
+    ApiShader *shad = (ApiShader *)hashmap_get_with_hash(
+        p_state->api_data->shaders, &seek, hash);
 
     if (shad == NULL) {
         seek.shader = LoadShader(vertex_shader, fragment_shader);
-        hashmap_set(p_state->api_data->shaders, &seek);
-    }
+        hashmap_set_with_hash(p_state->api_data->shaders, &seek, hash);
 
-    shad = (ApiShader *)hashmap_get(p_state->api_data->shaders, &seek);
+        shad = (ApiShader *)hashmap_get_with_hash(p_state->api_data->shaders,
+                                                  &seek, hash);
+    }
 
     assert(shad != NULL);
 
@@ -776,24 +1241,42 @@ typedef struct AnimationUpdateData {
     lua_State  *lua;
 } AnimationUpdateData;
 
+_Static_assert(sizeof(AnimationUpdateData) <= ANIMATION_USER_DATA_SIZE,
+               "animation user data does not fit in the pool");
+
 static void
-ApiAnimationUpdate(_Animation *anim, void *user_data, F64 dt) {
+ApiAnimationUpdate(Animations *anims, U32 slot, void *user_data, F64 dt) {
     AnimationUpdateData *data = (AnimationUpdateData *)user_data;
 
-    lua_pushlightuserdata(data->lua, anim);
+    lua_pushinteger(data->lua, AnimationsHandle(anims, slot));
     lua_pushnumber(data->lua, dt);
 
-    CallCallback(data->lua, &data->callback, 2);
+    CallCallback(data->lua, data->callback, 2);
+}
+
+// Drops the registry reference once the animation no longer needs it.
+static void
+ApiAnimationRelease(void *user_data) {
+    AnimationUpdateData *data = (AnimationUpdateData *)user_data;
+
+    FreeCallback(data->lua, &data->callback);
+}
+
+// Returns the pool slot of the animation handle at index, or -1 if it has
+// ended.
+static I32
+ToAnimation(lua_State *L, I32 index) {
+    return AnimationsResolve(p_state->animations, lua_tointeger(L, index));
 }
 
 static int
 L_AnimationGetElapsed(lua_State *L) {
-    CheckArgument(L, LUA_TLIGHTUSERDATA, 1, animation_get_elapsed);
+    CheckArgument(L, LUA_TNUMBER, 1, animation_get_elapsed);
 
-    _Animation *anim = lua_touserdata(L, 1);
+    I32 slot = ToAnimation(L, 1);
 
-    if (anim) {
-        lua_pushnumber(L, anim->elapsed);
+    if (slot >= 0) {
+        lua_pushnumber(L, p_state->animations->elapsed[slot]);
     } else {
         ApiError(L, "tried getting elapsed time of non-existent animation");
         lua_pushnumber(L, 0);
@@ -804,12 +1287,12 @@ L_AnimationGetElapsed(lua_State *L) {
 
 static int
 L_AnimationGetVal(lua_State *L) {
-    CheckArgument(L, LUA_TLIGHTUSERDATA, 1, animation_get_elapsed);
+    CheckArgument(L, LUA_TNUMBER, 1, animation_get_val);
 
-    _Animation *anim = lua_touserdata(L, 1);
+    I32 slot = ToAnimation(L, 1);
 
-    if (anim) {
-        lua_pushnumber(L, anim->val);
+    if (slot >= 0) {
+        lua_pushnumber(L, p_state->animations->val[slot]);
     } else {
         ApiError(L, "tried getting value of non-existent animation");
         lua_pushnumber(L, 0);
@@ -820,14 +1303,14 @@ L_AnimationGetVal(lua_State *L) {
 
 static int
 L_AnimationSetVal(lua_State *L) {
-    CheckArgument(L, LUA_TLIGHTUSERDATA, 1, animation_set_val);
+    CheckArgument(L, LUA_TNUMBER, 1, animation_set_val);
     CheckArgument(L, LUA_TNUMBER, 2, animation_set_val);
 
-    _Animation *anim = lua_touserdata(L, 1);
-    F32         val = lua_tonumber(L, 2);
+    I32 slot = ToAnimation(L, 1);
+    F32 val = lua_tonumber(L, 2);
 
-    if (anim) {
-        anim->val = val;
+    if (slot >= 0) {
+        p_state->animations->val[slot] = val;
     } else {
         ApiError(L, "tried setting value of non-existent animation");
     }
@@ -837,14 +1320,14 @@ L_AnimationSetVal(lua_State *L) {
 
 static int
 L_AnimationLoad(lua_State *L) {
-    CheckArgument(L, LUA_TLIGHTUSERDATA, 1, animation_load);
+    CheckArgument(L, LUA_TNUMBER, 1, animation_load);
     CheckArgument(L, LUA_TNUMBER, 2, animation_load);
 
-    _Animation *anim = lua_touserdata(L, 1);
-    F32         def = lua_tonumber(L, 2);
+    I32 slot = ToAnimation(L, 1);
+    F32 def = lua_tonumber(L, 2);
 
-    if (AnimationsExists(p_state->animations, anim->name)) {
-        lua_pushnumber(L, AnimationsLoad(p_state->animations, anim->name));
+    if (slot >= 0) {
+        lua_pushnumber(L, p_state->animations->val[slot]);
     } else {
         lua_pushnumber(L, def);
     }
@@ -854,12 +1337,12 @@ L_AnimationLoad(lua_State *L) {
 
 static int
 L_AnimationSetFinished(lua_State *L) {
-    CheckArgument(L, LUA_TLIGHTUSERDATA, 1, animation_set_finished);
+    CheckArgument(L, LUA_TNUMBER, 1, animation_set_finished);
 
-    _Animation *anim = lua_touserdata(L, 1);
+    I32 slot = ToAnimation(L, 1);
 
-    if (anim) {
-        anim->finished = true;
+    if (slot >= 0) {
+        p_state->animations->finished[slot] = true;
     } else {
         ApiError(L, "tried setting finished of non-existent animation");
     }
@@ -883,10 +1366,16 @@ L_AddAnimation(lua_State *L) {
         .lua = L,
     };
 
-    _Animation *anim = AnimationsAdd(p_state->animations, name, &data,
-                                     ApiAnimationUpdate, &p_state->arena);
+    AnimationHandle handle =
+        AnimationsAddWithRelease(p_state->animations, name, &data,
+                                 ApiAnimationUpdate, ApiAnimationRelease);
 
-    lua_pushlightuserdata(L, anim);
+    // The pool was full, so nothing holds the callback.
+    if (handle == ANIMATION_NONE) {
+        FreeCallback(L, &data.callback);
+    }
+
+    lua_pushinteger(L, handle);
 
     return 1;
 }
@@ -896,11 +1385,23 @@ typedef struct ProcedureCallbackData {
     lua_State  *L;
 } ProcedureCallbackData;
 
+_Static_assert(sizeof(ProcedureCallbackData) <= PROCEDURE_USER_DATA_SIZE,
+               "procedure user data does not fit");
+
 static void
 ProcedureCallbackWrapper(void *data) {
     ProcedureCallbackData *callback_data = (ProcedureCallbackData *)data;
 
-    CallCallback(callback_data->L, &callback_data->callback, 0);
+    CallCallback(callback_data->L, callback_data->callback, 0);
+}
+
+// Drops the registry reference once a procedure added under the same name
+// replaces this one.
+static void
+ProcedureCallbackRelease(void *data) {
+    ProcedureCallbackData *callback_data = (ProcedureCallbackData *)data;
+
+    FreeCallback(callback_data->L, &callback_data->callback);
 }
 
 static int
@@ -922,10 +1423,17 @@ L_AddProcedure(lua_State *L) {
         .L = L,
     };
 
-    Procedure *proc = ProcedureAdd(p_state->procedures, name, &data,
-                                   ProcedureCallbackWrapper, &p_state->arena);
+    ProcedureHandle handle =
+        ProcedureAddWithRelease(p_state->procedures, name, &data,
+                                ProcedureCallbackWrapper,
+                                ProcedureCallbackRelease);
 
-    lua_pushlightuserdata(L, proc);
+    // There was no room, so nothing holds the callback.
+    if (handle == PROCEDURE_NONE) {
+        FreeCallback(L, &data.callback);
+    }
+
+    lua_pushinteger(L, handle);
 
     lua_remove(L, -2);
 
@@ -936,11 +1444,9 @@ L_AddProcedure(lua_State *L) {
 
 static int
 L_CallProcedure(lua_State *L) {
-    CheckArgument(L, LUA_TLIGHTUSERDATA, 1, call_procedure);
-
-    const char *name = ((Procedure *)lua_touserdata(L, 1))->name;
+    CheckArgument(L, LUA_TNUMBER, 1, call_procedure);
 
-    ProcedureCall(p_state->procedures, name);
+    ProcedureCall(p_state->procedures, lua_tointeger(L, 1));
 
     return 0;
 }
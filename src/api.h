@@ -2,6 +2,7 @@
 
 #include "defines.h"
 #include "hashmap.h"
+#include "intern.h"
 #include "lua.h"
 #include "raylib.h"
 
@@ -19,8 +20,19 @@
 
 #define API_METHODS_RENDERER                                                   \
     X(L_DrawLinedPoly, draw_lined_poly)                                        \
+    X(L_DrawLines, draw_lines)                                                 \
+    X(L_DrawPolyline, draw_polyline)                                           \
+    X(L_DrawPolygon, draw_polygon)                                             \
+    X(L_DrawRects, draw_rects)                                                 \
+    X(L_DrawCircles, draw_circles)                                             \
     X(L_DrawCenteredText, draw_centered_text)
 
+#define API_METHODS_STEMS                                                      \
+    X(L_LoadStem, load)                                                        \
+    X(L_ClearStems, clear)                                                     \
+    X(L_GetStemSamples, get_samples)                                           \
+    X(L_GetStemFrequencies, get_frequencies)
+
 #define API_METHODS_PARAMS                                                     \
     X(L_AddParameter, add)                                                     \
     X(L_GetParameter, get)                                                     \
@@ -36,6 +48,8 @@
     X(L_GetBgColor, get_bg_color)                                              \
     X(L_GetScreenSize, get_screen_size)                                        \
     X(L_GetSamples, get_samples)                                               \
+    X(L_GetFrequencies, get_frequencies)                                       \
+    X(L_GetHistory, get_history)                                               \
     X(L_SmoothSignal, smooth_signal)                                           \
     X(L_BindShader, bind_shader)                                               \
     X(L_UnbindShader, unbind_shader)
@@ -47,16 +61,36 @@ typedef I32 ApiCallback;
 typedef struct ApiInterface {
     struct {
         Color bg_color;
+        U32   analysis_rate;
+        F32   history_seconds;
+
+        U32 realtime_priority;
+        I32 audio_core;
+        I32 analysis_core;
+
+        B8 alloc_check;
     } opt;
 } ApiInterface;
 
 typedef struct ApiShader {
-    char vertex[256];
-    char fragment[256];
+    // Full paths, interned. NULL uses raylib's default.
+    Intern vertex;
+    Intern fragment;
 
     Shader shader;
 } ApiShader;
 
+// Errors are printed at most once per interval per message. Messages that
+// land in the same slot share it.
+#define API_ERROR_SLOTS 32
+#define API_ERROR_INTERVAL 5.0
+
+typedef struct ApiErrorLog {
+    U64 hash;
+    F64 reported;
+    U32 suppressed;
+} ApiErrorLog;
+
 #define MAX_API_CALLBACKS 256
 typedef struct ApiData {
     lua_State   *lua;
@@ -75,6 +109,13 @@ typedef struct ApiData {
     U32         on_render_count;
 
     HM_Hashmap *shaders;
+
+    // Registry references to the FloatBuffers over State's samples and
+    // frequencies.
+    I32 samples;
+    I32 frequencies;
+
+    ApiErrorLog errors[API_ERROR_SLOTS];
 } ApiData;
 
 void
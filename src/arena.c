@@ -1,47 +1,128 @@
 #include "arena.h"
 
+#include "alloc.h"
 #include "defines.h"
+#include "lmath.h"
+#include "permanent_storage.h"
 
-#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+// base must already be usable for all size bytes.
 void
-ArenaInitialise(MemoryArena *arena, U32 size, U8 *base) {
+ArenaInitialise(MemoryArena *arena, U64 size, U8 *base) {
     arena->size = size;
     arena->base = base;
     arena->used = 0;
+    arena->committed = size;
+    arena->granule = 0;
+    arena->scratch = false;
+    arena->hint = NULL;
 }
 
-void *
-ArenaPushStruct_(MemoryArena *arena, U32 size) {
-    assert(arena->used + size <= arena->size);
+// base is only reserved; pages are committed as pushes reach them.
+void
+ArenaInitialiseReserved(MemoryArena *arena, U64 size, U8 *base, U64 granule) {
+    arena->size = size;
+    arena->base = base;
+    arena->used = 0;
+    arena->committed = 0;
+    arena->granule = granule;
+    arena->scratch = false;
+    arena->hint = NULL;
+}
 
-    void *result = arena->base + arena->used;
-    arena->used += size;
+// Running out is a fatal error, and isn't left to assert so it still stops
+// release builds.
+static void
+Exhausted(MemoryArena *arena, U64 size) {
+    fprintf(stderr,
+            "ERROR: arena out of memory (%llu of %llu bytes used, %llu more "
+            "requested).\n",
+            (unsigned long long)arena->used, (unsigned long long)arena->size,
+            (unsigned long long)size);
 
-    return result;
+    if (arena->hint) {
+        fprintf(stderr, "%s\n", arena->hint);
+    }
+
+    abort();
 }
 
-void *
-ArenaPushArray_(MemoryArena *arena, U32 count, U32 size) {
-    assert(arena->used + count * size <= arena->size);
+// Granules are counted from base, which is only page aligned, so the range
+// never starts below the reservation.
+static void
+Commit(MemoryArena *arena, U64 end) {
+    U64 from = arena->committed - arena->committed % arena->granule;
+    U64 to = end + (arena->granule - end % arena->granule) % arena->granule;
+
+    to = MinU64(to, arena->size);
+
+    if (!PermanentStorageCommit(arena->base + from, to - from)) {
+        Exhausted(arena, end - arena->used);
+    }
+
+    arena->committed = to;
+}
+
+static void *
+Push(MemoryArena *arena, U64 size, U64 alignment) {
+    uintptr_t at = (uintptr_t)(arena->base + arena->used);
+    U64       padding = (alignment - at % alignment) % alignment;
+
+    if (size + padding > arena->size - arena->used) {
+        Exhausted(arena, size + padding);
+    }
+
+    U64 end = arena->used + padding + size;
 
-    void *result = arena->base + arena->used;
-    arena->used += count * size;
+    if (end > arena->committed) {
+        Commit(arena, end);
+    }
+
+    void *result = arena->base + arena->used + padding;
+    arena->used = end;
 
     return result;
 }
 
-char *
-ArenaPushString(MemoryArena *arena, const char *string) {
-    U32 size = (strlen(string) + 1) * sizeof(char);
-    assert(arena->used + size <= arena->size);
+void *
+ArenaPushTagged(MemoryArena *arena, U64 size, U64 alignment, const char *file) {
+    if (!arena->scratch) {
+        AllocCountPush(file, size);
+    }
+
+    return Push(arena, size, alignment);
+}
 
-    char *result = (char *)(arena->base + arena->used);
-    arena->used += size;
+char *
+ArenaPushStringTagged(MemoryArena *arena,
+                      const char  *string,
+                      const char  *file) {
+    U64   size = (strlen(string) + 1) * sizeof(char);
+    char *result = ArenaPushTagged(arena, size, 1, file);
 
     strcpy(result, string);
 
     return result;
 }
+
+// Frees everything at once. Committed pages are kept, and stay warm for the
+// next round of pushes.
+void
+ArenaReset(MemoryArena *arena) {
+    arena->used = 0;
+}
+
+ArenaTemp
+ArenaBeginTemp(MemoryArena *arena) {
+    return (ArenaTemp){.arena = arena, .used = arena->used};
+}
+
+// Frees everything pushed since the matching ArenaBeginTemp.
+void
+ArenaEndTemp(ArenaTemp temp) {
+    temp.arena->used = temp.used;
+}
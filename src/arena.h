@@ -4,21 +4,62 @@
 
 typedef struct MemoryArena {
     U8 *base;
-    U32 size;
-    U32 used;
+    U64 size;
+    U64 used;
+
+    // Bytes from base backed by memory. Arenas over reserved address space
+    // commit more, granule bytes at a time, as they grow.
+    U64 committed;
+    U64 granule;
+
+    // Scratch arenas are reset every frame, so pushing onto them isn't
+    // counted as allocating.
+    B8 scratch;
+
+    // Printed after the error when the arena runs out, if set.
+    const char *hint;
 } MemoryArena;
 
+// Marks a point to roll an arena back to, so scratch memory used inside a
+// scope is reclaimed when it ends.
+typedef struct ArenaTemp {
+    MemoryArena *arena;
+    U64          used;
+} ArenaTemp;
+
+// Alignment of pushes that don't name a type.
+#define ARENA_ALIGNMENT 16
+
+// Pushes are counted against the file they are made from.
 #define ArenaPushStruct(arena, type)                                           \
-    (type *)ArenaPushStruct_(arena, sizeof(type))
+    (type *)ArenaPushTagged((arena), sizeof(type), _Alignof(type), __FILE__)
 
 #define ArenaPushArray(arena, count, type)                                     \
-    (type *)ArenaPushArray_(arena, count, sizeof(type))
+    (type *)ArenaPushTagged((arena), (U64)(count) * sizeof(type),             \
+                            _Alignof(type), __FILE__)
+
+#define ArenaPushStruct_(arena, size)                                          \
+    ArenaPushTagged((arena), (size), ARENA_ALIGNMENT, __FILE__)
+
+#define ArenaPushArray_(arena, count, size)                                    \
+    ArenaPushTagged((arena), (U64)(count) * (size), ARENA_ALIGNMENT, __FILE__)
+
+#define ArenaPushString(arena, string)                                         \
+    ArenaPushStringTagged((arena), (string), __FILE__)
 
 void
-ArenaInitialise(MemoryArena *arena, U32 size, U8 *base);
-void *
-ArenaPushStruct_(MemoryArena *arena, U32 size);
+ArenaInitialise(MemoryArena *arena, U64 size, U8 *base);
+void
+ArenaInitialiseReserved(MemoryArena *arena, U64 size, U8 *base, U64 granule);
 void *
-ArenaPushArray_(MemoryArena *arena, U32 count, U32 size);
+ArenaPushTagged(MemoryArena *arena, U64 size, U64 alignment, const char *file);
 char *
-ArenaPushString(MemoryArena *arena, const char *string);
+ArenaPushStringTagged(MemoryArena *arena,
+                      const char  *string,
+                      const char  *file);
+void
+ArenaReset(MemoryArena *arena);
+ArenaTemp
+ArenaBeginTemp(MemoryArena *arena);
+void
+ArenaEndTemp(ArenaTemp temp);
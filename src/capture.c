@@ -0,0 +1,220 @@
+#include "capture.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "arena.h"
+#include "defines.h"
+#include "lmath.h"
+#include "pcm_queue.h"
+#include "thread.h"
+
+#define WAVE_FORMAT_IEEE_FLOAT 3
+
+// RIFF header, fmt chunk and the JUNK chunk header, before the padding.
+#define CAPTURE_HEADER_SIZE 44
+
+static void
+PutU16(U8 *out, U16 value) {
+    memcpy(out, &value, sizeof(U16));
+}
+
+static void
+PutU32(U8 *out, U32 value) {
+    memcpy(out, &value, sizeof(U32));
+}
+
+// Fills out with a CAPTURE_ALIGNMENT byte header. A JUNK chunk pads it so the
+// samples start on an aligned offset.
+static void
+WriteHeader(Capture *capture, U8 *out) {
+    U32 frame_size = capture->channels * sizeof(F32);
+    U32 data_size = MinU64(capture->data_size, UINT32_MAX - CAPTURE_ALIGNMENT);
+
+    memset(out, 0, CAPTURE_ALIGNMENT);
+
+    memcpy(out, "RIFF", 4);
+    PutU32(out + 4, CAPTURE_ALIGNMENT - 8 + data_size);
+    memcpy(out + 8, "WAVE", 4);
+
+    memcpy(out + 12, "fmt ", 4);
+    PutU32(out + 16, 16);
+    PutU16(out + 20, WAVE_FORMAT_IEEE_FLOAT);
+    PutU16(out + 22, capture->channels);
+    PutU32(out + 24, capture->sample_rate);
+    PutU32(out + 28, capture->sample_rate * frame_size);
+    PutU16(out + 32, frame_size);
+    PutU16(out + 34, 32);
+
+    memcpy(out + 36, "JUNK", 4);
+    PutU32(out + 40, CAPTURE_ALIGNMENT - CAPTURE_HEADER_SIZE - 8);
+
+    memcpy(out + CAPTURE_ALIGNMENT - 8, "data", 4);
+    PutU32(out + CAPTURE_ALIGNMENT - 4, data_size);
+}
+
+static void
+Flush(Capture *capture) {
+    if (capture->buffered == 0) {
+        return;
+    }
+
+    fwrite(capture->buffer, 1, capture->buffered, capture->file);
+    capture->buffered = 0;
+}
+
+// Moves everything queued into the buffer, writing it out each time it fills.
+static void
+Drain(Capture *capture) {
+    U32 frame_size = capture->channels * sizeof(F32);
+
+    for (;;) {
+        U32 space = (CAPTURE_WRITE_SIZE - capture->buffered) / frame_size;
+        U32 count =
+            PcmQueueRead(&capture->queue,
+                         (F32 *)(capture->buffer + capture->buffered), space);
+
+        capture->buffered += count * frame_size;
+        capture->data_size += count * frame_size;
+
+        if (capture->buffered == CAPTURE_WRITE_SIZE) {
+            Flush(capture);
+        }
+
+        if (count < space) {
+            break;
+        }
+    }
+}
+
+static void *
+WriterThread(void *data) {
+    Capture *capture = data;
+
+    while (atomic_load(&capture->running)) {
+        Drain(capture);
+
+        ThreadSleep(CAPTURE_POLL_INTERVAL);
+    }
+
+    Drain(capture);
+    Flush(capture);
+
+    return NULL;
+}
+
+void
+CaptureInitialise(Capture *capture, MemoryArena *arena) {
+    memset(capture, 0, sizeof(Capture));
+
+    U8 *buffer =
+        ArenaPushStruct_(arena, CAPTURE_WRITE_SIZE + CAPTURE_ALIGNMENT);
+
+    capture->buffer =
+        buffer + (CAPTURE_ALIGNMENT - (uintptr_t)buffer % CAPTURE_ALIGNMENT) %
+                     CAPTURE_ALIGNMENT;
+    capture->thread = ThreadAlloc(arena);
+}
+
+// Starts writing to path. The callback's frames are kept from here on.
+B8
+CaptureBegin(Capture    *capture,
+             const char *path,
+             U32         sample_rate,
+             U32         channels) {
+    capture->file = fopen(path, "wb");
+
+    if (!capture->file) {
+        return false;
+    }
+
+    // The buffer already batches writes.
+    setvbuf(capture->file, NULL, _IONBF, 0);
+
+    capture->sample_rate = sample_rate;
+    capture->channels = MinU32(channels, PCM_QUEUE_MAX_CHANNELS);
+    capture->data_size = 0;
+
+    // The real sizes are filled in by CaptureEnd.
+    WriteHeader(capture, capture->buffer);
+    capture->buffered = CAPTURE_ALIGNMENT;
+
+    PcmQueueReset(&capture->queue, capture->channels);
+    atomic_store(&capture->dropped, 0);
+
+    atomic_store(&capture->running, true);
+    ThreadCreate(capture->thread, WriterThread, capture);
+
+    atomic_store(&capture->active, true);
+
+    return true;
+}
+
+// Called from the audio thread. Frames with more channels than the capture
+// keep only the first ones.
+void
+CaptureWrite(Capture *capture, const F32 *frames, U32 channels, U32 count) {
+    if (!atomic_load_explicit(&capture->active, memory_order_acquire)) {
+        return;
+    }
+
+    U32 free = PcmQueueFree(&capture->queue);
+
+    if (count > free) {
+        atomic_fetch_add(&capture->dropped, count - free);
+        count = free;
+    }
+
+    if (channels == capture->channels) {
+        PcmQueueWrite(&capture->queue, frames, count);
+        return;
+    }
+
+    F32 converted[512 * PCM_QUEUE_MAX_CHANNELS];
+
+    for (U32 i = 0; i < count; i += 512) {
+        U32 run = MinU32(512, count - i);
+
+        for (U32 j = 0; j < run; ++j) {
+            for (U32 c = 0; c < capture->channels; ++c) {
+                converted[j * capture->channels + c] =
+                    frames[(i + j) * channels + MinU32(c, channels - 1)];
+            }
+        }
+
+        PcmQueueWrite(&capture->queue, converted, run);
+    }
+}
+
+// Stops capturing, writes out what is left and fills in the header. Returns
+// false if anything failed to reach the file.
+B8
+CaptureEnd(Capture *capture) {
+    if (!capture->file) {
+        return false;
+    }
+
+    atomic_store(&capture->active, false);
+    atomic_store(&capture->running, false);
+    ThreadJoin(capture->thread);
+
+    U8 header[CAPTURE_ALIGNMENT];
+    WriteHeader(capture, header);
+
+    B8 ret = !ferror(capture->file);
+
+    ret = ret && fseek(capture->file, 0, SEEK_SET) == 0;
+    ret = ret && fwrite(header, 1, CAPTURE_ALIGNMENT, capture->file) ==
+                     CAPTURE_ALIGNMENT;
+    ret = fclose(capture->file) == 0 && ret;
+
+    capture->file = NULL;
+
+    U64 dropped = atomic_load(&capture->dropped);
+
+    if (dropped > 0) {
+        printf("Capture dropped %llu frames.\n", (unsigned long long)dropped);
+    }
+
+    return ret;
+}
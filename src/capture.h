@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "arena.h"
+#include "defines.h"
+#include "pcm_queue.h"
+#include "thread.h"
+
+// Bytes handed to the OS per write. The WAV header is padded out to
+// CAPTURE_ALIGNMENT, so every write starts on an aligned file offset.
+#define CAPTURE_WRITE_SIZE (1 << 18)
+#define CAPTURE_ALIGNMENT 4096
+
+// How long the writer thread sleeps once the queue is drained.
+#define CAPTURE_POLL_INTERVAL 0.01
+
+// Records live input to a float WAV file. The capture callback pushes frames
+// into a lock-free queue; a writer thread drains it in large blocks, so the
+// callback never touches the disk.
+typedef struct Capture {
+    Thread     *thread;
+    _Atomic I32 running;
+
+    // Set while the callback should be queueing frames.
+    _Atomic I32 active;
+
+    PcmQueue queue;
+
+    // Frames the callback couldn't queue because the writer fell behind.
+    _Atomic U64 dropped;
+
+    FILE *file;
+    U32   sample_rate;
+    U32   channels;
+    U64   data_size;
+
+    // CAPTURE_WRITE_SIZE bytes, aligned to CAPTURE_ALIGNMENT.
+    U8 *buffer;
+    U32 buffered;
+} Capture;
+
+void
+CaptureInitialise(Capture *capture, MemoryArena *arena);
+B8
+CaptureBegin(Capture    *capture,
+             const char *path,
+             U32         sample_rate,
+             U32         channels);
+void
+CaptureWrite(Capture *capture, const F32 *frames, U32 channels, U32 count);
+B8
+CaptureEnd(Capture *capture);
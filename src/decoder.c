@@ -0,0 +1,206 @@
+#include "decoder.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "alloc.h"
+#include "defines.h"
+#include "raylib.h"
+
+// Declarations only; the implementations are compiled into raylib.
+#include "external/dr_mp3.h"
+#include "external/dr_wav.h"
+
+// Stock raylib leaves SUPPORT_FILEFORMAT_FLAC off, so dr_flac is compiled
+// here instead.
+#define DR_FLAC_IMPLEMENTATION
+#include "external/dr_flac.h"
+
+#define STB_VORBIS_HEADER_ONLY
+#include "external/stb_vorbis.c"
+
+static DecoderFormat
+FormatFromPath(const char *path) {
+    if (IsFileExtension(path, ".wav")) {
+        return DecoderFormat_WAV;
+    }
+
+    if (IsFileExtension(path, ".mp3")) {
+        return DecoderFormat_MP3;
+    }
+
+    if (IsFileExtension(path, ".flac")) {
+        return DecoderFormat_FLAC;
+    }
+
+    if (IsFileExtension(path, ".ogg")) {
+        return DecoderFormat_OGG;
+    }
+
+    return DecoderFormat_NONE;
+}
+
+B8
+DecoderSupports(const char *path) {
+    return FormatFromPath(path) != DecoderFormat_NONE;
+}
+
+B8
+DecoderOpen(Decoder *decoder, const char *path) {
+    memset(decoder, 0, sizeof(Decoder));
+
+    decoder->format = FormatFromPath(path);
+
+    switch (decoder->format) {
+    case DecoderFormat_WAV: {
+        drwav *wav = AllocMalloc(AllocTag_DECODER, sizeof(drwav));
+
+        if (!drwav_init_file(wav, path, NULL)) {
+            AllocFree(AllocTag_DECODER, wav);
+            break;
+        }
+
+        decoder->handle = wav;
+        decoder->channels = wav->channels;
+        decoder->sample_rate = wav->sampleRate;
+        decoder->frame_count = wav->totalPCMFrameCount;
+    } break;
+
+    case DecoderFormat_MP3: {
+        drmp3 *mp3 = AllocMalloc(AllocTag_DECODER, sizeof(drmp3));
+
+        if (!drmp3_init_file(mp3, path, NULL)) {
+            AllocFree(AllocTag_DECODER, mp3);
+            break;
+        }
+
+        decoder->handle = mp3;
+        decoder->channels = mp3->channels;
+        decoder->sample_rate = mp3->sampleRate;
+        decoder->frame_count = drmp3_get_pcm_frame_count(mp3);
+
+        // Counting frames scans the whole file.
+        drmp3_seek_to_pcm_frame(mp3, 0);
+    } break;
+
+    case DecoderFormat_FLAC: {
+        drflac *flac = drflac_open_file(path, NULL);
+
+        if (!flac) {
+            break;
+        }
+
+        decoder->handle = flac;
+        decoder->channels = flac->channels;
+        decoder->sample_rate = flac->sampleRate;
+        decoder->frame_count = flac->totalPCMFrameCount;
+    } break;
+
+    case DecoderFormat_OGG: {
+        stb_vorbis *ogg = stb_vorbis_open_filename(path, NULL, NULL);
+
+        if (!ogg) {
+            break;
+        }
+
+        stb_vorbis_info info = stb_vorbis_get_info(ogg);
+
+        decoder->handle = ogg;
+        decoder->channels = info.channels;
+        decoder->sample_rate = info.sample_rate;
+        decoder->frame_count = stb_vorbis_stream_length_in_samples(ogg);
+    } break;
+
+    default:
+        break;
+    }
+
+    if (!decoder->handle) {
+        return false;
+    }
+
+    if (decoder->channels == 0 || decoder->channels > DECODER_MAX_CHANNELS ||
+        decoder->sample_rate == 0) {
+        DecoderClose(decoder);
+        return false;
+    }
+
+    return true;
+}
+
+void
+DecoderClose(Decoder *decoder) {
+    if (!decoder->handle) {
+        return;
+    }
+
+    switch (decoder->format) {
+    case DecoderFormat_WAV: {
+        drwav_uninit(decoder->handle);
+        AllocFree(AllocTag_DECODER, decoder->handle);
+    } break;
+
+    case DecoderFormat_MP3: {
+        drmp3_uninit(decoder->handle);
+        AllocFree(AllocTag_DECODER, decoder->handle);
+    } break;
+
+    case DecoderFormat_FLAC: {
+        drflac_close(decoder->handle);
+    } break;
+
+    case DecoderFormat_OGG: {
+        stb_vorbis_close(decoder->handle);
+    } break;
+
+    default:
+        break;
+    }
+
+    decoder->handle = NULL;
+}
+
+// Returns the number of frames read, which is less than frame_count only at
+// the end of the file.
+U32
+DecoderRead(Decoder *decoder, F32 *frames, U32 frame_count) {
+    switch (decoder->format) {
+    case DecoderFormat_WAV:
+        return drwav_read_pcm_frames_f32(decoder->handle, frame_count, frames);
+
+    case DecoderFormat_MP3:
+        return drmp3_read_pcm_frames_f32(decoder->handle, frame_count, frames);
+
+    case DecoderFormat_FLAC:
+        return drflac_read_pcm_frames_f32(decoder->handle, frame_count,
+                                          frames);
+
+    case DecoderFormat_OGG:
+        return stb_vorbis_get_samples_float_interleaved(
+            decoder->handle, decoder->channels, frames,
+            frame_count * decoder->channels);
+
+    default:
+        return 0;
+    }
+}
+
+B8
+DecoderSeek(Decoder *decoder, U64 frame) {
+    switch (decoder->format) {
+    case DecoderFormat_WAV:
+        return drwav_seek_to_pcm_frame(decoder->handle, frame);
+
+    case DecoderFormat_MP3:
+        return drmp3_seek_to_pcm_frame(decoder->handle, frame);
+
+    case DecoderFormat_FLAC:
+        return drflac_seek_to_pcm_frame(decoder->handle, frame);
+
+    case DecoderFormat_OGG:
+        return stb_vorbis_seek(decoder->handle, frame);
+
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include "defines.h"
+
+#define DECODER_MAX_CHANNELS 8
+
+// Extensions accepted by DecoderOpen, in the form LoadDirectoryFilesEx takes.
+#define DECODER_EXTENSIONS ".wav;.mp3;.flac;.ogg"
+
+typedef enum DecoderFormat {
+    DecoderFormat_NONE = 0,
+    DecoderFormat_WAV,
+    DecoderFormat_MP3,
+    DecoderFormat_FLAC,
+    DecoderFormat_OGG,
+} DecoderFormat;
+
+// Streams interleaved float frames out of an audio file. Wraps the decoders
+// that ship with raylib, so nothing extra is linked.
+typedef struct Decoder {
+    DecoderFormat format;
+    void         *handle;
+
+    U32 channels;
+    U32 sample_rate;
+    U64 frame_count;
+} Decoder;
+
+B8
+DecoderSupports(const char *path);
+B8
+DecoderOpen(Decoder *decoder, const char *path);
+void
+DecoderClose(Decoder *decoder);
+U32
+DecoderRead(Decoder *decoder, F32 *frames, U32 frame_count);
+B8
+DecoderSeek(Decoder *decoder, U64 frame);
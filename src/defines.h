@@ -21,10 +21,32 @@ typedef double F64;
 
 #define ARRAY_LEN(a) sizeof((a)) / sizeof((a)[0])
 #define SAMPLE_COUNT (1 << 15)
+#define FREQUENCY_COUNT 2048
 #define RENDER_FPS 60
 #define LOG_MUL 1.06f
 #define START_FREQ 1.0f
 
+// Rate every input is resampled to before analysis, unless init.lua sets
+// lynx.opt.analysis_rate.
+#define ANALYSIS_SAMPLE_RATE 44100
+
+// Seconds of analysis audio kept for scripts, unless init.lua sets
+// lynx.opt.history_seconds.
+#define HISTORY_SECONDS 30
+
+// Periods the playback device keeps queued (miniaudio's default). Used to
+// estimate how far decoded audio runs ahead of the speakers.
+#define AUDIO_DEVICE_PERIODS 3
+
+// Data written by different threads is kept this far apart, so that neither
+// has to keep taking the line back from the other. Apple silicon moves 128
+// bytes at a time.
+#if defined(__APPLE__) && defined(__aarch64__)
+#define CACHE_LINE_SIZE 128
+#else
+#define CACHE_LINE_SIZE 64
+#endif
+
 #define API_URI "https://lynx-backend-satvikprasad.koyeb.app/api/v1"
 
 #if defined(_WIN32)
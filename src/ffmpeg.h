@@ -3,6 +3,7 @@
 #include "defines.h"
 #include "handmademath.h"
 
-I32 FFMPEGStart(HMM_Vec2 size, U32 fps, const char *music);
+I32 FFMPEGStart(HMM_Vec2 size, U32 fps, const char *music, const char *output);
 void FFMPEGEnd(I32 pipe);
 void FFMPEGWrite(I32 pipe, void *data, HMM_Vec2 size);
+B8 FFMPEGMux(const char *video, const char *audio, const char *output);
@@ -9,8 +9,10 @@
 #include "ffmpeg.h"
 #include "handmademath.h"
 
+// Starts ffmpeg encoding raw frames from the returned pipe into output. The
+// audio comes from music, or is left out if music is NULL.
 I32
-FFMPEGStart(HMM_Vec2 size, U32 fps, const char *music) {
+FFMPEGStart(HMM_Vec2 size, U32 fps, const char *music, const char *output) {
     I32 pipefd[2];
 
     if (pipe(pipefd) < 0) {
@@ -41,11 +43,21 @@ FFMPEGStart(HMM_Vec2 size, U32 fps, const char *music) {
         char framerate[64];
         snprintf(framerate, sizeof(resolution), "%u", fps);
 
-        I32 err = execlp("ffmpeg", "ffmpeg", "-loglevel", "verbose", "-y", "-f",
-                         "rawvideo", "-pix_fmt", "rgba", "-s", resolution, "-r",
-                         framerate, "-i", "-", "-i", music, "-c:v", "libx264",
-                         "-vb", "20M", "-c:a", "aac", "-pix_fmt", "yuv420p",
-                         "output.mp4", NULL);
+        I32 err;
+
+        if (music) {
+            err = execlp("ffmpeg", "ffmpeg", "-loglevel", "verbose", "-y",
+                         "-f", "rawvideo", "-pix_fmt", "rgba", "-s",
+                         resolution, "-r", framerate, "-i", "-", "-i", music,
+                         "-c:v", "libx264", "-vb", "20M", "-c:a", "aac",
+                         "-pix_fmt", "yuv420p", output, NULL);
+        } else {
+            err = execlp("ffmpeg", "ffmpeg", "-loglevel", "verbose", "-y",
+                         "-f", "rawvideo", "-pix_fmt", "rgba", "-s",
+                         resolution, "-r", framerate, "-i", "-", "-c:v",
+                         "libx264", "-vb", "20M", "-pix_fmt", "yuv420p",
+                         output, NULL);
+        }
 
         if (err < 0) {
             fprintf(stderr,
@@ -70,6 +82,33 @@ FFMPEGEnd(I32 pipe) {
     wait(NULL);
 }
 
+// Copies the video from video and encodes the audio from audio into output.
+// Blocks until ffmpeg exits.
+B8
+FFMPEGMux(const char *video, const char *audio, const char *output) {
+    pid_t child = fork();
+    if (child < 0) {
+        fprintf(stderr, "ERROR: could not fork a child: %s\n", strerror(errno));
+        return false;
+    }
+
+    if (child == 0) {
+        execlp("ffmpeg", "ffmpeg", "-loglevel", "verbose", "-y", "-i", video,
+               "-i", audio, "-c:v", "copy", "-c:a", "aac", "-shortest", output,
+               NULL);
+
+        fprintf(stderr, "ERROR: could not run ffmpeg: %s\n", strerror(errno));
+        _exit(1);
+    }
+
+    I32 status;
+    if (waitpid(child, &status, 0) < 0) {
+        return false;
+    }
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
 void
 FFMPEGWrite(I32 pipe, void *data, HMM_Vec2 size) {
     for (U32 i = size.Height; i > 0; --i) {
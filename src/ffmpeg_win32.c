@@ -4,8 +4,14 @@
 #include "ffmpeg.h"
 #include "handmademath.h"
 
-I32 FFMPEGStart(HMM_Vec2 size, U32 fps, const char *music) { return -1; }
+I32 FFMPEGStart(HMM_Vec2 size, U32 fps, const char *music, const char *output) {
+    return -1;
+}
 
 void FFMPEGEnd(I32 pipe) {}
 
 void FFMPEGWrite(I32 pipe, void *data, HMM_Vec2 size) {}
+
+B8 FFMPEGMux(const char *video, const char *audio, const char *output) {
+    return false;
+}
@@ -23,3 +23,11 @@ FSGetApolloDirectory(char *path);
 
 B8
 FSCanRunCMD(const char *cmd);
+
+// Maps a whole file read-only. Returns NULL if it can't be opened or is
+// empty.
+const void *
+FSMapFile(const char *path, U64 *size);
+
+void
+FSUnmapFile(const void *data, U64 size);
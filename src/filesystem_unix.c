@@ -1,8 +1,10 @@
 #include "defines.h"
 #include "filesystem.h"
 #include "raylib.h"
+#include <fcntl.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -105,3 +107,37 @@ FSCanRunCMD(const char *cmd) {
     free(buf);
     return false;
 }
+
+const void *
+FSMapFile(const char *path, U64 *size) {
+    int fd = open(path, O_RDONLY);
+
+    if (fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    void       *data = NULL;
+
+    if (fstat(fd, &st) == 0 && st.st_size > 0) {
+        data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+        if (data == MAP_FAILED) {
+            data = NULL;
+        }
+    }
+
+    // The mapping keeps the file alive.
+    close(fd);
+
+    *size = data ? st.st_size : 0;
+
+    return data;
+}
+
+void
+FSUnmapFile(const void *data, U64 size) {
+    if (data) {
+        munmap((void *)data, size);
+    }
+}
@@ -0,0 +1,90 @@
+#include "free_list.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "arena.h"
+#include "defines.h"
+#include "mutex.h"
+
+#define FREE_LIST_ALIGNMENT 16
+
+void
+FreeListInitialise(FreeList    *list,
+                   const char  *name,
+                   U64          size,
+                   MemoryArena *arena) {
+    memset(list, 0, sizeof(FreeList));
+
+    if (size < sizeof(FreeListNode)) {
+        size = sizeof(FreeListNode);
+    }
+
+    list->name = name;
+    list->size = (size + FREE_LIST_ALIGNMENT - 1) &
+                 ~(U64)(FREE_LIST_ALIGNMENT - 1);
+    list->arena = arena;
+
+    MutexCreate(&list->mutex);
+}
+
+void
+FreeListDestroy(FreeList *list) {
+    MutexDestroy(&list->mutex);
+}
+
+// Returns a zeroed slot, reusing a freed one when there is one.
+void *
+FreeListAlloc(FreeList *list) {
+    MutexLock(&list->mutex);
+
+    void *data = list->free;
+
+    if (data) {
+        list->free = list->free->next;
+    } else {
+        data = ArenaPushTagged(list->arena, list->size, FREE_LIST_ALIGNMENT,
+                               __FILE__);
+        list->capacity++;
+    }
+
+    list->live++;
+
+    if (list->live > list->high_water) {
+        list->high_water = list->live;
+    }
+
+    MutexUnlock(&list->mutex);
+
+    memset(data, 0, list->size);
+
+    return data;
+}
+
+void
+FreeListFree(FreeList *list, void *data) {
+    if (!data) {
+        return;
+    }
+
+    MutexLock(&list->mutex);
+
+    FreeListNode *node = data;
+    node->next = list->free;
+    list->free = node;
+
+    list->live--;
+
+    MutexUnlock(&list->mutex);
+}
+
+void
+FreeListReport(FreeList *list) {
+    MutexLock(&list->mutex);
+
+    printf("Pool %s: %u live, %u high water, %u slots (%.1f KB)\n", list->name,
+           list->live, list->high_water, list->capacity,
+           list->capacity * list->size / 1024.0);
+
+    MutexUnlock(&list->mutex);
+}
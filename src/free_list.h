@@ -0,0 +1,44 @@
+#pragma once
+
+#include "arena.h"
+#include "defines.h"
+#include "mutex.h"
+
+typedef struct FreeListNode {
+    struct FreeListNode *next;
+} FreeListNode;
+
+// Fixed-size slots carved from an arena. Freed slots are kept on a list and
+// handed out again, so objects that come and go for the life of the program
+// stop growing the arena once the peak has been reached. Safe to use from
+// any thread.
+typedef struct FreeList {
+    const char  *name;
+    U64          size;
+    MemoryArena *arena;
+
+    Mutex         mutex;
+    FreeListNode *free;
+
+    U32 live;
+    U32 high_water;
+    U32 capacity;
+} FreeList;
+
+#define FreeListInitialiseType(list, type, arena)                              \
+    FreeListInitialise((list), #type, sizeof(type), (arena))
+#define FreeListAllocStruct(list, type) (type *)FreeListAlloc((list))
+
+void
+FreeListInitialise(FreeList    *list,
+                   const char  *name,
+                   U64          size,
+                   MemoryArena *arena);
+void
+FreeListDestroy(FreeList *list);
+void *
+FreeListAlloc(FreeList *list);
+void
+FreeListFree(FreeList *list, void *data);
+void
+FreeListReport(FreeList *list);
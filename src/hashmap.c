@@ -438,6 +438,635 @@ B8 hashmap_iter(HM_Hashmap *map, U32 *i, void **item) {
     return true;
 }
 
+//-----------------------------------------------------------------------------
+// Dense hash map
+//
+// Entries are stored contiguously in insertion order, and the Robin Hood map
+// above only holds their positions. Iterating is a linear walk over the
+// entries, and the order never depends on the hashes.
+//
+// Deleting only marks an entry, so it is safe while iterating. Deleted
+// entries are squeezed out by a later insert that would otherwise have to
+// grow the entries, which moves the entries after them.
+//-----------------------------------------------------------------------------
+
+// Position of the key being looked up, which isn't one of the entries.
+#define DENSE_PROBE ((U32)-1)
+
+static void *dense_entry(HM_Dense *map, U32 position) {
+    if (position == DENSE_PROBE) {
+        return (void *)map->probe;
+    }
+    return map->entries + (U64)position * map->elsize;
+}
+
+// Every index operation passes the hash in, so this is never called.
+static U64 dense_index_hash(const void *item, U64 seed0, U64 seed1) {
+    (void)item;
+    (void)seed0;
+    (void)seed1;
+    return 0;
+}
+
+static I32 dense_index_compare(const void *a, const void *b, void *udata) {
+    HM_Dense *map = udata;
+    return map->compare(dense_entry(map, *(U32 *)a),
+                        dense_entry(map, *(U32 *)b), map->udata);
+}
+
+// hashmap_dense_new_with_allocator returns a new dense hash map using a
+// custom allocator. The parameters are the same as for hashmap_new.
+HM_Dense *hashmap_dense_new_with_allocator(
+    void *(*_malloc)(U32),
+    void *(*_realloc)(void *, U32),
+    void (*_free)(void *),
+    U32 elsize,
+    U32 cap,
+    U64 seed0,
+    U64 seed1,
+    U64 (*hash)(const void *item, U64 seed0, U64 seed1),
+    I32 (*compare)(const void *a, const void *b, void *udata),
+    void (*elfree)(void *item),
+    void *udata) {
+    // The index resolves the default allocator, and the rest follows it.
+    HM_Hashmap *index = hashmap_new_with_allocator(
+        _malloc, _realloc, _free, sizeof(U32), cap, seed0, seed1,
+        dense_index_hash, dense_index_compare, NULL, NULL);
+    if (!index) {
+        return NULL;
+    }
+    HM_Dense *map = index->malloc(sizeof(HM_Dense));
+    if (!map) {
+        hashmap_free(index);
+        return NULL;
+    }
+    memset(map, 0, sizeof(HM_Dense));
+    map->malloc = index->malloc;
+    map->realloc = index->realloc;
+    map->free = index->free;
+    map->elsize = elsize;
+    map->seed0 = seed0;
+    map->seed1 = seed1;
+    map->hash = hash;
+    map->compare = compare;
+    map->elfree = elfree;
+    map->udata = udata;
+    map->index = index;
+    index->udata = map;
+    return map;
+}
+
+// hashmap_dense_new returns a new dense hash map. See hashmap_new.
+HM_Dense *hashmap_dense_new(U32 elsize,
+                            U32 cap,
+                            U64 seed0,
+                            U64 seed1,
+                            U64 (*hash)(const void *item, U64 seed0, U64 seed1),
+                            I32 (*compare)(const void *a,
+                                           const void *b,
+                                           void       *udata),
+                            void (*elfree)(void *item),
+                            void *udata) {
+    return hashmap_dense_new_with_allocator(NULL, NULL, NULL, elsize, cap,
+                                            seed0, seed1, hash, compare,
+                                            elfree, udata);
+}
+
+// hashmap_dense_free frees the map, calling elfree on every live entry.
+void hashmap_dense_free(HM_Dense *map) {
+    if (!map) {
+        return;
+    }
+    if (map->elfree) {
+        for (U32 i = 0; i < map->count; i++) {
+            if (!map->deleted[i]) {
+                map->elfree(dense_entry(map, i));
+            }
+        }
+    }
+    hashmap_free(map->index);
+    map->free(map->entries);
+    map->free(map->hashes);
+    map->free(map->deleted);
+    map->free(map);
+}
+
+// Moves the live entries down over the deleted ones, keeping their order,
+// and points the index at their new positions.
+static void dense_compact(HM_Dense *map) {
+    U32 count = 0;
+    hashmap_clear(map->index, true);
+    for (U32 i = 0; i < map->count; i++) {
+        if (map->deleted[i]) {
+            continue;
+        }
+        if (count != i) {
+            memcpy(dense_entry(map, count), dense_entry(map, i), map->elsize);
+            map->hashes[count] = map->hashes[i];
+            map->deleted[count] = false;
+        }
+        hashmap_set_with_hash(map->index, &count, map->hashes[count]);
+        count++;
+    }
+    map->count = count;
+}
+
+// Only malloc and free, like the rest of the library, so
+// hashmap_set_allocator covers it.
+static B8 dense_grow(HM_Dense *map) {
+    U32 cap = map->cap ? map->cap * 2 : 16;
+    U8 *entries = map->malloc(cap * map->elsize);
+    U64 *hashes = map->malloc(cap * sizeof(U64));
+    B8 *deleted = map->malloc(cap * sizeof(B8));
+    if (!entries || !hashes || !deleted) {
+        map->free(entries);
+        map->free(hashes);
+        map->free(deleted);
+        return false;
+    }
+    if (map->count) {
+        memcpy(entries, map->entries, map->count * map->elsize);
+        memcpy(hashes, map->hashes, map->count * sizeof(U64));
+        memcpy(deleted, map->deleted, map->count * sizeof(B8));
+    }
+    map->free(map->entries);
+    map->free(map->hashes);
+    map->free(map->deleted);
+    map->entries = entries;
+    map->hashes = hashes;
+    map->deleted = deleted;
+    map->cap = cap;
+    return true;
+}
+
+static const U32 *dense_find(HM_Dense *map, const void *key, U64 hash) {
+    U32 probe = DENSE_PROBE;
+    map->probe = key;
+    const U32 *position = hashmap_get_with_hash(map->index, &probe, hash);
+    map->probe = NULL;
+    return position;
+}
+
+// hashmap_dense_set_with_hash works like hashmap_dense_set but you provide
+// your own hash.
+const void *
+hashmap_dense_set_with_hash(HM_Dense *map, const void *item, U64 hash) {
+    hash = clip_hash(hash);
+    map->oom = false;
+    const U32 *found = dense_find(map, item, hash);
+    if (found) {
+        void *entry = dense_entry(map, *found);
+        memcpy(entry, item, map->elsize);
+        return entry;
+    }
+    if (map->count == map->cap) {
+        if (map->count - map->live >= map->count / 2 && map->count > 0) {
+            dense_compact(map);
+        } else if (!dense_grow(map)) {
+            map->oom = true;
+            return NULL;
+        }
+    }
+    // The index compares entries while it probes, so the item has to be in
+    // place before its position goes in. Until count moves past it, a failed
+    // insert leaves nothing behind.
+    U32 position = map->count;
+    void *entry = dense_entry(map, position);
+    memcpy(entry, item, map->elsize);
+    map->hashes[position] = hash;
+    map->deleted[position] = false;
+    hashmap_set_with_hash(map->index, &position, hash);
+    if (hashmap_oom(map->index)) {
+        map->oom = true;
+        return NULL;
+    }
+    map->count++;
+    map->live++;
+    return entry;
+}
+
+// hashmap_dense_set inserts an item after all the others, or replaces the
+// item with the same key where it stands. Unlike hashmap_set, it returns the
+// stored entry, or NULL if the system is out of memory.
+const void *hashmap_dense_set(HM_Dense *map, const void *item) {
+    return hashmap_dense_set_with_hash(
+        map, item, map->hash(item, map->seed0, map->seed1));
+}
+
+// hashmap_dense_get_with_hash works like hashmap_dense_get but you provide
+// your own hash.
+const void *
+hashmap_dense_get_with_hash(HM_Dense *map, const void *key, U64 hash) {
+    const U32 *found = dense_find(map, key, clip_hash(hash));
+    return found ? dense_entry(map, *found) : NULL;
+}
+
+// hashmap_dense_get returns the entry matching key, or NULL.
+const void *hashmap_dense_get(HM_Dense *map, const void *key) {
+    return hashmap_dense_get_with_hash(
+        map, key, map->hash(key, map->seed0, map->seed1));
+}
+
+// hashmap_dense_delete_with_hash works like hashmap_dense_delete but you
+// provide your own hash.
+const void *
+hashmap_dense_delete_with_hash(HM_Dense *map, const void *key, U64 hash) {
+    hash = clip_hash(hash);
+    const U32 *found = dense_find(map, key, hash);
+    if (!found) {
+        return NULL;
+    }
+    U32 position = *found;
+    U32 probe = DENSE_PROBE;
+    map->probe = key;
+    hashmap_delete_with_hash(map->index, &probe, hash);
+    map->probe = NULL;
+    map->deleted[position] = true;
+    map->live--;
+    return dense_entry(map, position);
+}
+
+// hashmap_dense_delete removes the entry matching key and returns it, or
+// NULL if there is none. The entry stays readable until the next insert.
+const void *hashmap_dense_delete(HM_Dense *map, const void *key) {
+    return hashmap_dense_delete_with_hash(
+        map, key, map->hash(key, map->seed0, map->seed1));
+}
+
+// hashmap_dense_count returns the number of live entries.
+U32 hashmap_dense_count(HM_Dense *map) { return map->live; }
+
+// hashmap_dense_oom returns true if the last hashmap_dense_set() call failed
+// due to the system being out of memory.
+B8 hashmap_dense_oom(HM_Dense *map) { return map->oom; }
+
+// hashmap_dense_at returns the entry at position, or NULL if it has been
+// deleted. Positions count entries in insertion order and only change when
+// deleted entries are compacted away.
+const void *hashmap_dense_at(HM_Dense *map, U32 position) {
+    if (position >= map->count || map->deleted[position]) {
+        return NULL;
+    }
+    return dense_entry(map, position);
+}
+
+// hashmap_dense_position returns the position of an entry returned by the
+// map.
+U32 hashmap_dense_position(HM_Dense *map, const void *entry) {
+    return ((const U8 *)entry - map->entries) / map->elsize;
+}
+
+// hashmap_dense_iter works like hashmap_iter, yielding entries in insertion
+// order. Deleting entries while iterating is safe.
+B8 hashmap_dense_iter(HM_Dense *map, U32 *i, void **item) {
+    while (*i < map->count) {
+        U32 position = (*i)++;
+        if (!map->deleted[position]) {
+            *item = dense_entry(map, position);
+            return true;
+        }
+    }
+    return false;
+}
+
+//-----------------------------------------------------------------------------
+// Swiss table
+//
+// Open addressing with a control byte per slot, probed a group of 16 at a
+// time. A full slot's control byte holds 7 bits of its hash, so the compare
+// callback only runs on slots whose tag already matches. Groups are scanned
+// with SSE2 or NEON where available.
+//
+// A lookup stops at the first group with an empty slot. The map grows, or
+// rehashes in place to clear out deleted slots, once 7/8 of it is used.
+//-----------------------------------------------------------------------------
+
+#define SWISS_GROUP 16
+#define SWISS_EMPTY 0x80
+#define SWISS_DELETED 0xFE
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define HASHMAP_SSE2
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define HASHMAP_NEON
+#endif
+
+#if defined(HASHMAP_NEON)
+// One bit per lane of a comparison result, lane 0 lowest.
+static U32 swiss_neon_mask(uint8x16_t lanes) {
+    static const U8 bits[16] = {1, 2, 4, 8, 16, 32, 64, 128,
+                                1, 2, 4, 8, 16, 32, 64, 128};
+    uint8x16_t set = vandq_u8(lanes, vld1q_u8(bits));
+    return vaddv_u8(vget_low_u8(set)) | (vaddv_u8(vget_high_u8(set)) << 8);
+}
+#endif
+
+// Bit i is set if ctrl[i] == tag.
+static U32 swiss_match(const U8 *ctrl, U8 tag) {
+#if defined(HASHMAP_SSE2)
+    __m128i group = _mm_loadu_si128((const __m128i *)ctrl);
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(tag)));
+#elif defined(HASHMAP_NEON)
+    return swiss_neon_mask(vceqq_u8(vld1q_u8(ctrl), vdupq_n_u8(tag)));
+#else
+    U32 mask = 0;
+    for (U32 i = 0; i < SWISS_GROUP; i++) {
+        mask |= (U32)(ctrl[i] == tag) << i;
+    }
+    return mask;
+#endif
+}
+
+// Bit i is set if slot i is empty or deleted, which are the control bytes
+// with the top bit set.
+static U32 swiss_match_free(const U8 *ctrl) {
+#if defined(HASHMAP_SSE2)
+    return _mm_movemask_epi8(_mm_loadu_si128((const __m128i *)ctrl));
+#elif defined(HASHMAP_NEON)
+    return swiss_neon_mask(vcltzq_s8(vld1q_s8((const I8 *)ctrl)));
+#else
+    U32 mask = 0;
+    for (U32 i = 0; i < SWISS_GROUP; i++) {
+        mask |= (U32)(ctrl[i] >> 7) << i;
+    }
+    return mask;
+#endif
+}
+
+// malloc itself takes a size_t, which the allocator signature does not.
+static void *swiss_malloc(U32 size) { return malloc(size); }
+
+static U32 swiss_h1(U64 hash) { return (U32)(hash >> 7); }
+
+static U8 swiss_h2(U64 hash) { return hash & 0x7F; }
+
+static void *swiss_slot(HM_Swiss *map, U32 i) {
+    return map->slots + (U64)i * map->elsize;
+}
+
+// Finds the slot holding key, or -1.
+static I64 swiss_find(HM_Swiss *map, const void *key, U64 hash) {
+    U32 mask = map->cap / SWISS_GROUP - 1;
+    U32 group = swiss_h1(hash) & mask;
+    U8  tag = swiss_h2(hash);
+    for (U32 step = 0; step <= mask; step++) {
+        const U8 *ctrl = map->ctrl + group * SWISS_GROUP;
+        U32       matches = swiss_match(ctrl, tag);
+        while (matches) {
+            U32 i = group * SWISS_GROUP + __builtin_ctz(matches);
+            if (map->compare(key, swiss_slot(map, i), map->udata) == 0) {
+                return i;
+            }
+            matches &= matches - 1;
+        }
+        if (swiss_match(ctrl, SWISS_EMPTY)) {
+            return -1;
+        }
+        // Triangular steps visit every group once.
+        group = (group + step + 1) & mask;
+    }
+    return -1;
+}
+
+// First empty or deleted slot on hash's probe sequence. The load limit
+// guarantees there is one.
+static U32 swiss_find_free(HM_Swiss *map, U64 hash) {
+    U32 mask = map->cap / SWISS_GROUP - 1;
+    U32 group = swiss_h1(hash) & mask;
+    for (U32 step = 0;; step++) {
+        U32 free = swiss_match_free(map->ctrl + group * SWISS_GROUP);
+        if (free) {
+            return group * SWISS_GROUP + __builtin_ctz(free);
+        }
+        group = (group + step + 1) & mask;
+    }
+}
+
+static void swiss_put(HM_Swiss *map, U32 i, const void *item, U64 hash) {
+    map->ctrl[i] = swiss_h2(hash);
+    map->hashes[i] = hash;
+    memcpy(swiss_slot(map, i), item, map->elsize);
+}
+
+static B8 swiss_alloc(HM_Swiss *map, U32 cap) {
+    U8 *ctrl = map->malloc(cap);
+    U64 *hashes = map->malloc(cap * sizeof(U64));
+    U8 *slots = map->malloc(cap * map->elsize);
+    if (!ctrl || !hashes || !slots) {
+        if (ctrl) {
+            map->free(ctrl);
+        }
+        if (hashes) {
+            map->free(hashes);
+        }
+        if (slots) {
+            map->free(slots);
+        }
+        return false;
+    }
+    memset(ctrl, SWISS_EMPTY, cap);
+    map->ctrl = ctrl;
+    map->hashes = hashes;
+    map->slots = slots;
+    map->cap = cap;
+    map->growat = cap / 8 * 7;
+    return true;
+}
+
+// Moves everything into a table of cap slots, dropping deleted slots.
+static B8 swiss_resize(HM_Swiss *map, U32 cap) {
+    HM_Swiss old = *map;
+    if (!swiss_alloc(map, cap)) {
+        return false;
+    }
+    for (U32 i = 0; i < old.cap; i++) {
+        if (!(old.ctrl[i] & 0x80)) {
+            U32 j = swiss_find_free(map, old.hashes[i]);
+            swiss_put(map, j, old.slots + (U64)i * old.elsize, old.hashes[i]);
+        }
+    }
+    map->deleted = 0;
+    map->free(old.ctrl);
+    map->free(old.hashes);
+    map->free(old.slots);
+    return true;
+}
+
+// hashmap_swiss_new_with_allocator returns a new swiss table using a custom
+// allocator. The parameters are the same as for hashmap_new.
+HM_Swiss *hashmap_swiss_new_with_allocator(
+    void *(*_malloc)(U32),
+    void *(*_realloc)(void *, U32),
+    void (*_free)(void *),
+    U32 elsize,
+    U32 cap,
+    U64 seed0,
+    U64 seed1,
+    U64 (*hash)(const void *item, U64 seed0, U64 seed1),
+    I32 (*compare)(const void *a, const void *b, void *udata),
+    void (*elfree)(void *item),
+    void *udata) {
+    _malloc = _malloc ? _malloc : __malloc ? __malloc : swiss_malloc;
+    _free = _free ? _free : __free ? __free : free;
+    HM_Swiss *map = _malloc(sizeof(HM_Swiss) + elsize);
+    if (!map) {
+        return NULL;
+    }
+    memset(map, 0, sizeof(HM_Swiss));
+    map->malloc = _malloc;
+    map->realloc = _realloc;
+    map->free = _free;
+    map->elsize = elsize;
+    map->seed0 = seed0;
+    map->seed1 = seed1;
+    map->hash = hash;
+    map->compare = compare;
+    map->elfree = elfree;
+    map->udata = udata;
+    map->spare = map + 1;
+    U32 ncap = SWISS_GROUP;
+    while (ncap < cap) {
+        ncap *= 2;
+    }
+    if (!swiss_alloc(map, ncap)) {
+        _free(map);
+        return NULL;
+    }
+    return map;
+}
+
+// hashmap_swiss_new returns a new swiss table. See hashmap_new.
+HM_Swiss *hashmap_swiss_new(U32 elsize,
+                            U32 cap,
+                            U64 seed0,
+                            U64 seed1,
+                            U64 (*hash)(const void *item, U64 seed0, U64 seed1),
+                            I32 (*compare)(const void *a,
+                                           const void *b,
+                                           void       *udata),
+                            void (*elfree)(void *item),
+                            void *udata) {
+    return hashmap_swiss_new_with_allocator(NULL, NULL, NULL, elsize, cap,
+                                            seed0, seed1, hash, compare,
+                                            elfree, udata);
+}
+
+// hashmap_swiss_free frees the map, calling elfree on every item.
+void hashmap_swiss_free(HM_Swiss *map) {
+    if (!map) {
+        return;
+    }
+    if (map->elfree) {
+        for (U32 i = 0; i < map->cap; i++) {
+            if (!(map->ctrl[i] & 0x80)) {
+                map->elfree(swiss_slot(map, i));
+            }
+        }
+    }
+    map->free(map->ctrl);
+    map->free(map->hashes);
+    map->free(map->slots);
+    map->free(map);
+}
+
+// hashmap_swiss_set_with_hash works like hashmap_swiss_set but you provide
+// your own hash.
+const void *
+hashmap_swiss_set_with_hash(HM_Swiss *map, const void *item, U64 hash) {
+    map->oom = false;
+    I64 found = swiss_find(map, item, hash);
+    if (found >= 0) {
+        void *slot = swiss_slot(map, found);
+        memcpy(map->spare, slot, map->elsize);
+        memcpy(slot, item, map->elsize);
+        return map->spare;
+    }
+    if (map->count + map->deleted >= map->growat) {
+        // Mostly deleted slots are cleared out without growing.
+        U32 cap = map->count >= map->growat / 2 ? map->cap * 2 : map->cap;
+        if (!swiss_resize(map, cap)) {
+            map->oom = true;
+            return NULL;
+        }
+    }
+    U32 i = swiss_find_free(map, hash);
+    if (map->ctrl[i] == SWISS_DELETED) {
+        map->deleted--;
+    }
+    swiss_put(map, i, item, hash);
+    map->count++;
+    return NULL;
+}
+
+// hashmap_swiss_set works like hashmap_set.
+const void *hashmap_swiss_set(HM_Swiss *map, const void *item) {
+    return hashmap_swiss_set_with_hash(
+        map, item, map->hash(item, map->seed0, map->seed1));
+}
+
+// hashmap_swiss_get_with_hash works like hashmap_swiss_get but you provide
+// your own hash.
+const void *
+hashmap_swiss_get_with_hash(HM_Swiss *map, const void *key, U64 hash) {
+    I64 found = swiss_find(map, key, hash);
+    return found >= 0 ? swiss_slot(map, found) : NULL;
+}
+
+// hashmap_swiss_get works like hashmap_get.
+const void *hashmap_swiss_get(HM_Swiss *map, const void *key) {
+    return hashmap_swiss_get_with_hash(
+        map, key, map->hash(key, map->seed0, map->seed1));
+}
+
+// hashmap_swiss_delete_with_hash works like hashmap_swiss_delete but you
+// provide your own hash.
+const void *
+hashmap_swiss_delete_with_hash(HM_Swiss *map, const void *key, U64 hash) {
+    I64 found = swiss_find(map, key, hash);
+    if (found < 0) {
+        return NULL;
+    }
+    memcpy(map->spare, swiss_slot(map, found), map->elsize);
+    // No lookup ever went past a group with an empty slot, so the slot can
+    // be emptied rather than marked.
+    U8 *group = map->ctrl + (found & ~(U64)(SWISS_GROUP - 1));
+    if (swiss_match(group, SWISS_EMPTY)) {
+        map->ctrl[found] = SWISS_EMPTY;
+    } else {
+        map->ctrl[found] = SWISS_DELETED;
+        map->deleted++;
+    }
+    map->count--;
+    return map->spare;
+}
+
+// hashmap_swiss_delete works like hashmap_delete.
+const void *hashmap_swiss_delete(HM_Swiss *map, const void *key) {
+    return hashmap_swiss_delete_with_hash(
+        map, key, map->hash(key, map->seed0, map->seed1));
+}
+
+// hashmap_swiss_count returns the number of items in the map.
+U32 hashmap_swiss_count(HM_Swiss *map) { return map->count; }
+
+// hashmap_swiss_oom returns true if the last hashmap_swiss_set() call failed
+// due to the system being out of memory.
+B8 hashmap_swiss_oom(HM_Swiss *map) { return map->oom; }
+
+// hashmap_swiss_iter works like hashmap_iter.
+B8 hashmap_swiss_iter(HM_Swiss *map, U32 *i, void **item) {
+    while (*i < map->cap) {
+        U32 slot = (*i)++;
+        if (!(map->ctrl[slot] & 0x80)) {
+            *item = swiss_slot(map, slot);
+            return true;
+        }
+    }
+    return false;
+}
+
 //-----------------------------------------------------------------------------
 // SipHash reference C implementation
 //
@@ -893,13 +1522,13 @@ static void shuffle(void *array, U32 numels, U32 elsize) {
 }
 
 static B8 iter_ints(const void *item, void *udata) {
-    I32 *vals = *(i32 **)udata;
+    I32 *vals = *(I32 **)udata;
     vals[*(I32 *)item] = 1;
     return true;
 }
 
 static I32 compare_ints_udata(const void *a, const void *b, void *udata) {
-    return *(I32 *)a - *(i32 *)b;
+    return *(I32 *)a - *(I32 *)b;
 }
 
 static I32 compare_strs(const void *a, const void *b, void *udata) {
@@ -1087,6 +1716,210 @@ static void all(void) {
     }
 }
 
+static U64 hash_collide(const void *item, U64 seed0, U64 seed1) {
+    (void)item;
+    (void)seed0;
+    (void)seed1;
+    return 7;
+}
+
+static void dense(void) {
+    I32 N = getenv("N") ? atoi(getenv("N")) : 2000;
+
+    rand_alloc_fail = false;
+
+    HM_Dense *map = hashmap_dense_new(sizeof(I32), 0, 0, 0, hash_int,
+                                      compare_ints_udata, NULL, NULL);
+    assert(map);
+
+    for (I32 i = 0; i < N; i++) {
+        const I32 *entry = hashmap_dense_set(map, &i);
+        assert(entry && *entry == i);
+        assert(hashmap_dense_position(map, entry) == (U32)i);
+    }
+    assert(hashmap_dense_count(map) == (U32)N);
+
+    // Iterates in insertion order, and deleting as it goes is safe.
+    U32  iter = 0;
+    I32 *item;
+    I32  expect = 0;
+    while (hashmap_dense_iter(map, &iter, (void **)&item)) {
+        assert(*item == expect++);
+        if (*item % 2) {
+            I32 key = *item;
+            assert(hashmap_dense_delete(map, &key));
+        }
+    }
+    assert(expect == N);
+    assert(hashmap_dense_count(map) == (U32)(N + 1) / 2);
+
+    for (I32 i = 0; i < N; i++) {
+        assert((hashmap_dense_get(map, &i) != NULL) == (i % 2 == 0));
+    }
+
+    // Enough inserts to compact the deleted entries away; order is kept.
+    for (I32 i = N; i < 2 * N; i++) {
+        assert(hashmap_dense_set(map, &i));
+    }
+    iter = 0;
+    I32 last = -1;
+    while (hashmap_dense_iter(map, &iter, (void **)&item)) {
+        assert(*item > last);
+        assert(*item >= N || *item % 2 == 0);
+        assert(*(I32 *)hashmap_dense_get(map, item) == *item);
+        last = *item;
+    }
+
+    hashmap_dense_free(map);
+
+    // Every key collides, so inserts compare against the entry being added.
+    // After a compaction the slot past the end still holds a moved entry.
+    map = hashmap_dense_new(sizeof(I32), 0, 0, 0, hash_collide,
+                            compare_ints_udata, NULL, NULL);
+    assert(map);
+    for (I32 i = 0; i < 16; i++) {
+        assert(hashmap_dense_set(map, &i));
+    }
+    for (I32 i = 0; i < 8; i++) {
+        assert(hashmap_dense_delete(map, &i));
+    }
+    for (I32 i = 16; i < 32; i++) {
+        assert(hashmap_dense_set(map, &i));
+    }
+    assert(hashmap_dense_count(map) == 24);
+    for (I32 i = 8; i < 32; i++) {
+        assert(*(I32 *)hashmap_dense_get(map, &i) == i);
+    }
+    hashmap_dense_free(map);
+
+    if (total_allocs != 0) {
+        fprintf(stderr, "total_allocs: expected 0, got %lu\n", total_allocs);
+        exit(1);
+    }
+}
+
+static void swiss(void) {
+    I32 N = getenv("N") ? atoi(getenv("N")) : 2000;
+
+    rand_alloc_fail = false;
+
+    HM_Swiss *map = hashmap_swiss_new(sizeof(I32), 0, 0, 0, hash_int,
+                                      compare_ints_udata, NULL, NULL);
+    assert(map);
+
+    I32 *vals = xmalloc(N * sizeof(I32));
+    for (I32 i = 0; i < N; i++) {
+        vals[i] = i;
+    }
+    shuffle(vals, N, sizeof(I32));
+
+    for (I32 i = 0; i < N; i++) {
+        assert(!hashmap_swiss_set(map, &vals[i]));
+        assert(hashmap_swiss_count(map) == (U32)i + 1);
+    }
+    for (I32 i = 0; i < N; i++) {
+        assert(*(I32 *)hashmap_swiss_get(map, &i) == i);
+        assert(*(I32 *)hashmap_swiss_set(map, &i) == i);
+    }
+
+    // Churn through deletes and inserts so deleted slots pile up and get
+    // cleared out.
+    for (I32 round = 0; round < 8; round++) {
+        for (I32 i = 0; i < N; i += 2) {
+            assert(*(I32 *)hashmap_swiss_delete(map, &i) == i);
+            assert(!hashmap_swiss_get(map, &i));
+        }
+        assert(hashmap_swiss_count(map) == (U32)N / 2);
+        for (I32 i = 0; i < N; i++) {
+            assert((hashmap_swiss_get(map, &i) != NULL) == (i % 2 == 1));
+        }
+        for (I32 i = 0; i < N; i += 2) {
+            assert(!hashmap_swiss_set(map, &i));
+        }
+    }
+
+    U32  iter = 0;
+    I32 *item;
+    I32  seen = 0;
+    while (hashmap_swiss_iter(map, &iter, (void **)&item)) {
+        seen++;
+    }
+    assert(seen == N);
+
+    hashmap_swiss_free(map);
+    xfree(vals);
+
+    if (total_allocs != 0) {
+        fprintf(stderr, "total_allocs: expected 0, got %lu\n", total_allocs);
+        exit(1);
+    }
+}
+
+// Lookups of string keys at the sizes the app's maps actually reach. Hashes
+// are worked out beforehand, as they are for interned keys, so only the
+// tables are timed. Hits and misses are timed separately.
+static F64 swiss_bench_time(void) {
+    return (F64)clock() / CLOCKS_PER_SEC;
+}
+
+static void swiss_benchmarks(void) {
+    U32 sizes[] = {16, 64, 256, 1024, 4096};
+    U32 lookups = 1 << 22;
+
+    printf("%6s %14s %14s %14s %14s\n", "size", "robin hit", "swiss hit",
+           "robin miss", "swiss miss");
+
+    for (U32 s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++) {
+        U32    n = sizes[s];
+        char **keys = xmalloc(2 * n * sizeof(char *));
+        U64   *hashes = xmalloc(2 * n * sizeof(U64));
+        for (U32 i = 0; i < 2 * n; i++) {
+            keys[i] = xmalloc(16);
+            snprintf(keys[i], 16, "key %u", i);
+            hashes[i] = hash_str(&keys[i], 0, 0);
+        }
+
+        HM_Hashmap *robin = hashmap_new(sizeof(char *), 0, 0, 0, hash_str,
+                                        compare_strs, NULL, NULL);
+        HM_Swiss   *table = hashmap_swiss_new(sizeof(char *), 0, 0, 0,
+                                              hash_str, compare_strs, NULL,
+                                              NULL);
+        for (U32 i = 0; i < n; i++) {
+            hashmap_set_with_hash(robin, &keys[i], hashes[i]);
+            hashmap_swiss_set_with_hash(table, &keys[i], hashes[i]);
+        }
+
+        F64 ns[4];
+        U32 found = 0;
+        for (U32 pass = 0; pass < 4; pass++) {
+            // Hits use the first n keys, misses the second n.
+            U32 base = pass >= 2 ? n : 0;
+            F64 start = swiss_bench_time();
+            for (U32 i = 0; i < lookups; i++) {
+                U32 k = base + (i & (n - 1));
+                found += pass % 2 == 0
+                             ? hashmap_get_with_hash(robin, &keys[k],
+                                                     hashes[k]) != NULL
+                             : hashmap_swiss_get_with_hash(table, &keys[k],
+                                                           hashes[k]) != NULL;
+            }
+            ns[pass] = (swiss_bench_time() - start) * 1e9 / lookups;
+        }
+        assert(found == lookups * 2);
+
+        printf("%6u %11.1f ns %11.1f ns %11.1f ns %11.1f ns\n", n, ns[0],
+               ns[1], ns[2], ns[3]);
+
+        hashmap_free(robin);
+        hashmap_swiss_free(table);
+        for (U32 i = 0; i < 2 * n; i++) {
+            xfree(keys[i]);
+        }
+        xfree(keys);
+        xfree(hashes);
+    }
+}
+
 #define bench(name, N, code)                                                   \
     {                                                                          \
         {                                                                      \
@@ -1184,9 +2017,12 @@ I32 main(void) {
     if (getenv("BENCH")) {
         printf("Running hashmap.c benchmarks...\n");
         benchmarks();
+        swiss_benchmarks();
     } else {
         printf("Running hashmap.c tests...\n");
         all();
+        dense();
+        swiss();
         printf("PASSED\n");
     }
 }
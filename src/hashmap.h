@@ -79,3 +79,132 @@ hashmap_delete_with_hash(HM_Hashmap *map, const void *key, U64 hash);
 const void *hashmap_set_with_hash(HM_Hashmap *map, const void *item, U64 hash);
 void        hashmap_set_grow_by_power(HM_Hashmap *map, U32 power);
 void        hashmap_set_load_factor(HM_Hashmap *map, F64 load_factor);
+
+// Entries in insertion order, with index holding their positions. See the
+// dense hash map section of hashmap.c.
+typedef struct HM_Dense {
+    void *(*malloc)(U32);
+    void *(*realloc)(void *, U32);
+    void (*free)(void *);
+    U32 elsize;
+    U64 seed0;
+    U64 seed1;
+    U64 (*hash)(const void *item, U64 seed0, U64 seed1);
+    int (*compare)(const void *a, const void *b, void *udata);
+    void (*elfree)(void *item);
+    void *udata;
+
+    HM_Hashmap *index;
+    const void *probe;
+
+    U8  *entries;
+    U64 *hashes;
+    B8  *deleted;
+    U32  count;
+    U32  live;
+    U32  cap;
+    B8   oom;
+} HM_Dense;
+
+HM_Dense *
+hashmap_dense_new(U32 elsize,
+                  U32 cap,
+                  U64 seed0,
+                  U64 seed1,
+                  U64 (*hash)(const void *item, U64 seed0, U64 seed1),
+                  int (*compare)(const void *a, const void *b, void *udata),
+                  void (*elfree)(void *item),
+                  void *udata);
+
+HM_Dense *hashmap_dense_new_with_allocator(
+    void *(*malloc)(U32),
+    void *(*realloc)(void *, U32),
+    void (*free)(void *),
+    U32 elsize,
+    U32 cap,
+    U64 seed0,
+    U64 seed1,
+    U64 (*hash)(const void *item, U64 seed0, U64 seed1),
+    int (*compare)(const void *a, const void *b, void *udata),
+    void (*elfree)(void *item),
+    void *udata);
+
+void        hashmap_dense_free(HM_Dense *map);
+U32         hashmap_dense_count(HM_Dense *map);
+B8          hashmap_dense_oom(HM_Dense *map);
+const void *hashmap_dense_get(HM_Dense *map, const void *key);
+const void *hashmap_dense_set(HM_Dense *map, const void *item);
+const void *hashmap_dense_delete(HM_Dense *map, const void *key);
+const void *hashmap_dense_at(HM_Dense *map, U32 position);
+U32         hashmap_dense_position(HM_Dense *map, const void *entry);
+B8          hashmap_dense_iter(HM_Dense *map, U32 *i, void **item);
+
+const void *
+hashmap_dense_get_with_hash(HM_Dense *map, const void *key, U64 hash);
+const void *
+hashmap_dense_set_with_hash(HM_Dense *map, const void *item, U64 hash);
+const void *
+hashmap_dense_delete_with_hash(HM_Dense *map, const void *key, U64 hash);
+
+// Open addressing with a control byte per slot. See the swiss table section
+// of hashmap.c.
+typedef struct HM_Swiss {
+    void *(*malloc)(U32);
+    void *(*realloc)(void *, U32);
+    void (*free)(void *);
+    U32 elsize;
+    U64 seed0;
+    U64 seed1;
+    U64 (*hash)(const void *item, U64 seed0, U64 seed1);
+    int (*compare)(const void *a, const void *b, void *udata);
+    void (*elfree)(void *item);
+    void *udata;
+
+    U8   *ctrl;
+    U64  *hashes;
+    U8   *slots;
+    U32   cap;
+    U32   count;
+    U32   deleted;
+    U32   growat;
+    B8    oom;
+    void *spare;
+} HM_Swiss;
+
+HM_Swiss *
+hashmap_swiss_new(U32 elsize,
+                  U32 cap,
+                  U64 seed0,
+                  U64 seed1,
+                  U64 (*hash)(const void *item, U64 seed0, U64 seed1),
+                  int (*compare)(const void *a, const void *b, void *udata),
+                  void (*elfree)(void *item),
+                  void *udata);
+
+HM_Swiss *hashmap_swiss_new_with_allocator(
+    void *(*malloc)(U32),
+    void *(*realloc)(void *, U32),
+    void (*free)(void *),
+    U32 elsize,
+    U32 cap,
+    U64 seed0,
+    U64 seed1,
+    U64 (*hash)(const void *item, U64 seed0, U64 seed1),
+    int (*compare)(const void *a, const void *b, void *udata),
+    void (*elfree)(void *item),
+    void *udata);
+
+void        hashmap_swiss_free(HM_Swiss *map);
+U32         hashmap_swiss_count(HM_Swiss *map);
+B8          hashmap_swiss_oom(HM_Swiss *map);
+const void *hashmap_swiss_get(HM_Swiss *map, const void *key);
+const void *hashmap_swiss_set(HM_Swiss *map, const void *item);
+const void *hashmap_swiss_delete(HM_Swiss *map, const void *key);
+B8          hashmap_swiss_iter(HM_Swiss *map, U32 *i, void **item);
+
+const void *
+hashmap_swiss_get_with_hash(HM_Swiss *map, const void *key, U64 hash);
+const void *
+hashmap_swiss_set_with_hash(HM_Swiss *map, const void *item, U64 hash);
+const void *
+hashmap_swiss_delete_with_hash(HM_Swiss *map, const void *key, U64 hash);
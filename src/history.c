@@ -0,0 +1,105 @@
+#include "history.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "arena.h"
+#include "defines.h"
+#include "lmath.h"
+
+void
+HistoryInitialise(History *history, U32 rate, F32 seconds, MemoryArena *arena) {
+    history->rate = rate;
+    // One spare, as the chunk being filled is kept outside the array.
+    history->chunk_count = ceilf(seconds * rate / HISTORY_CHUNK_FRAMES) + 1;
+    history->chunks =
+        ArenaPushArray(arena, history->chunk_count, HistoryChunk);
+
+    HistoryReset(history);
+}
+
+void
+HistoryReset(History *history) {
+    history->written = 0;
+
+    memset(history->chunks, 0, history->chunk_count * sizeof(HistoryChunk));
+    memset(history->pending, 0, sizeof(history->pending));
+}
+
+static void
+Compress(History *history, U64 chunk) {
+    HistoryChunk *out = &history->chunks[chunk % history->chunk_count];
+    F32           peak = 0.0f;
+
+    for (U32 i = 0; i < HISTORY_CHUNK_FRAMES; ++i) {
+        peak = MaxF32(peak, fabsf(history->pending[i]));
+    }
+
+    out->scale = peak / INT16_MAX;
+
+    F32 inverse = peak > 0.0f ? INT16_MAX / peak : 0.0f;
+
+    for (U32 i = 0; i < HISTORY_CHUNK_FRAMES; ++i) {
+        out->samples[i] = lrintf(history->pending[i] * inverse);
+    }
+}
+
+void
+HistoryWrite(History *history, const F32 *samples, U32 count) {
+    while (count > 0) {
+        U32 offset = history->written % HISTORY_CHUNK_FRAMES;
+        U32 run = MinU32(count, HISTORY_CHUNK_FRAMES - offset);
+
+        memcpy(history->pending + offset, samples, run * sizeof(F32));
+
+        history->written += run;
+        samples += run;
+        count -= run;
+
+        if (offset + run == HISTORY_CHUNK_FRAMES) {
+            Compress(history, history->written / HISTORY_CHUNK_FRAMES - 1);
+        }
+    }
+}
+
+U64
+HistoryWritten(History *history) {
+    return history->written;
+}
+
+// Frames that can be read back, including the partial chunk.
+U64
+HistoryCapacity(History *history) {
+    return (U64)(history->chunk_count - 1) * HISTORY_CHUNK_FRAMES +
+           history->written % HISTORY_CHUNK_FRAMES;
+}
+
+// Reads count frames, stride apart, with the last one just before frame end.
+// Only the frames asked for are decoded, so a long stride over the whole
+// history costs no more than a short one. Frames outside the history read as
+// silence.
+void
+HistoryRead(History *history, U64 end, F32 *out, U32 count, U32 stride) {
+    U64 partial = history->written - history->written % HISTORY_CHUNK_FRAMES;
+    U64 capacity = HistoryCapacity(history);
+    U64 oldest = history->written > capacity ? history->written - capacity : 0;
+
+    stride = MaxU32(stride, 1);
+
+    for (U32 i = 0; i < count; ++i) {
+        I64 frame = (I64)end - (I64)(count - i) * stride;
+
+        if (frame < (I64)oldest || frame >= (I64)history->written) {
+            out[i] = 0.0f;
+        } else if ((U64)frame >= partial) {
+            out[i] = history->pending[frame - partial];
+        } else {
+            HistoryChunk *chunk =
+                &history->chunks[(frame / HISTORY_CHUNK_FRAMES) %
+                                 history->chunk_count];
+
+            out[i] = chunk->samples[frame % HISTORY_CHUNK_FRAMES] *
+                     chunk->scale;
+        }
+    }
+}
@@ -0,0 +1,40 @@
+#pragma once
+
+#include "arena.h"
+#include "defines.h"
+
+#define HISTORY_CHUNK_FRAMES 1024
+
+// A block of samples sharing one scale, so quiet passages keep their
+// resolution.
+typedef struct HistoryChunk {
+    F32 scale;
+    I16 samples[HISTORY_CHUNK_FRAMES];
+} HistoryChunk;
+
+// The last few seconds of analysis audio, in about half the memory of
+// floats. Frames are numbered the same way as the sample ring they are copied
+// from. Completed chunks are stored as block-float int16; the chunk being
+// filled is kept as floats until it is full.
+typedef struct History {
+    U32 rate;
+    U32 chunk_count;
+    U64 written;
+
+    HistoryChunk *chunks;
+
+    F32 pending[HISTORY_CHUNK_FRAMES];
+} History;
+
+void
+HistoryInitialise(History *history, U32 rate, F32 seconds, MemoryArena *arena);
+void
+HistoryReset(History *history);
+void
+HistoryWrite(History *history, const F32 *samples, U32 count);
+U64
+HistoryWritten(History *history);
+U64
+HistoryCapacity(History *history);
+void
+HistoryRead(History *history, U64 end, F32 *out, U32 count, U32 stride);
@@ -0,0 +1,94 @@
+#include "intern.h"
+
+#include <string.h>
+
+#include "alloc.h"
+#include "arena.h"
+#include "defines.h"
+#include "hashmap.h"
+
+static struct {
+    HM_Hashmap  *map;
+    MemoryArena *arena;
+} table;
+
+static U64
+Hash(const char *text, U32 length) {
+    return hashmap_xxhash3(text, length, 0, 0);
+}
+
+static U64
+InternHash(const void *item, U64 seed0, U64 seed1) {
+    (void)(seed0);
+    (void)(seed1);
+
+    return (*(Intern *)item)->hash;
+}
+
+static I32
+InternCompare(const void *a, const void *b, void *udata) {
+    (void)(udata);
+
+    Intern ia = *(Intern *)a;
+    Intern ib = *(Intern *)b;
+
+    if (ia->length != ib->length) {
+        return ia->length < ib->length ? -1 : 1;
+    }
+
+    return memcmp(ia->text, ib->text, ia->length);
+}
+
+void
+InternInitialise(MemoryArena *arena) {
+    table.arena = arena;
+    table.map = hashmap_new_with_allocator(
+        AllocHashmapMalloc, AllocHashmapRealloc, AllocHashmapFree,
+        sizeof(Intern), 0, 0, 0, InternHash, InternCompare, NULL, NULL);
+}
+
+void
+InternDestroy() {
+    hashmap_free(table.map);
+    table.map = NULL;
+}
+
+static Intern
+Lookup(InternString *key) {
+    Intern *found = (Intern *)hashmap_get_with_hash(table.map, &key, key->hash);
+
+    return found ? *found : NULL;
+}
+
+// Returns the interned copy of text, adding it if this is the first time.
+Intern
+InternGet(const char *text) {
+    InternString key = {.text = text, .length = strlen(text)};
+    key.hash = Hash(text, key.length);
+
+    Intern found = Lookup(&key);
+
+    if (found) {
+        return found;
+    }
+
+    InternString *string = ArenaPushStruct(table.arena, InternString);
+
+    string->text = ArenaPushString(table.arena, text);
+    string->length = key.length;
+    string->hash = key.hash;
+
+    hashmap_set_with_hash(table.map, &(Intern){string}, string->hash);
+
+    return string;
+}
+
+// Like InternGet, but returns NULL rather than adding text. For lookups that
+// shouldn't grow the table.
+Intern
+InternFind(const char *text) {
+    InternString key = {.text = text, .length = strlen(text)};
+    key.hash = Hash(text, key.length);
+
+    return Lookup(&key);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "arena.h"
+#include "defines.h"
+
+// One copy of every string interned so far, with its hash worked out once.
+// Interning the same text twice gives back the same pointer, so two interned
+// strings are equal exactly when their pointers are.
+typedef struct InternString {
+    const char *text;
+    U32         length;
+    U64         hash;
+} InternString;
+
+typedef const InternString *Intern;
+
+// Strings live on the arena and are never released. Only used from the
+// main thread.
+void
+InternInitialise(MemoryArena *arena);
+void
+InternDestroy();
+
+Intern
+InternGet(const char *text);
+Intern
+InternFind(const char *text);
@@ -21,6 +21,24 @@ MinU32(U32 a, U32 b) {
     return b;
 }
 
+U64
+MaxU64(U64 a, U64 b) {
+    if (a > b) {
+        return a;
+    }
+
+    return b;
+}
+
+U64
+MinU64(U64 a, U64 b) {
+    if (a < b) {
+        return a;
+    }
+
+    return b;
+}
+
 F32
 MinF32(F32 a, F32 b) {
     if (a < b) {
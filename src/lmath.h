@@ -8,6 +8,10 @@ U32
 MaxU32(U32 a, U32 b);
 U32
 MinU32(U32 a, U32 b);
+U64
+MaxU64(U64 a, U64 b);
+U64
+MinU64(U64 a, U64 b);
 
 F32
 MinF32(F32 a, F32 b);
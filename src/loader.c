@@ -0,0 +1,185 @@
+#include "loader.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "arena.h"
+#include "defines.h"
+#include "lmath.h"
+#include "thread.h"
+#include "track.h"
+
+// Share of the progress bar covered by opening the decoder and decoding the
+// head. The rest is spent reading ahead.
+#define LOADER_OPEN_SHARE 0.5f
+
+static void
+PrimeFile(TrackLoader *loader) {
+    FILE *fptr = fopen(loader->path, "rb");
+
+    if (!fptr) {
+        return;
+    }
+
+    fseek(fptr, 0, SEEK_END);
+    U32 total = MinU32(ftell(fptr), LOADER_PRIME_BYTES);
+    fseek(fptr, 0, SEEK_SET);
+
+    char buf[64 * 1024];
+    U32  read = 0;
+
+    while (read < total) {
+        U32 n = fread(buf, 1, MinU32(sizeof(buf), total - read), fptr);
+
+        if (n == 0) {
+            break;
+        }
+
+        read += n;
+
+        atomic_store(&loader->progress,
+                     LOADER_OPEN_SHARE +
+                         (1.0f - LOADER_OPEN_SHARE) * read / (F32)total);
+    }
+
+    fclose(fptr);
+}
+
+static void *
+LoaderThread(void *data) {
+    TrackLoader *loader = (TrackLoader *)data;
+
+    if (!TrackOpen(&loader->track, loader->path)) {
+        atomic_store(&loader->status, TrackLoaderStatus_FAILED);
+        return NULL;
+    }
+
+    atomic_store(&loader->progress, LOADER_OPEN_SHARE);
+    atomic_store(&loader->status, TrackLoaderStatus_PRIMING);
+
+    PrimeFile(loader);
+
+    atomic_store(&loader->progress, 1.0f);
+    atomic_store(&loader->status, TrackLoaderStatus_READY);
+
+    return NULL;
+}
+
+static void
+Start(TrackLoader *loader, const char *path) {
+    strcpy(loader->path, path);
+
+    atomic_store(&loader->progress, 0.0f);
+    atomic_store(&loader->status, TrackLoaderStatus_OPENING);
+
+    loader->running = true;
+    loader->discard = false;
+    ThreadCreate(loader->thread, LoaderThread, loader);
+}
+
+void
+TrackLoaderInitialise(TrackLoader *loader, MemoryArena *arena) {
+    memset(loader, 0, sizeof(TrackLoader));
+
+    loader->thread = ThreadAlloc(arena);
+}
+
+void
+TrackLoaderDestroy(TrackLoader *loader) {
+    if (loader->running) {
+        ThreadJoin(loader->thread);
+
+        if (atomic_load(&loader->status) == TrackLoaderStatus_READY) {
+            TrackClose(&loader->track);
+        }
+    }
+}
+
+void
+TrackLoaderRequest(TrackLoader *loader, const char *path) {
+    if (loader->running) {
+        strcpy(loader->pending, path);
+        loader->has_pending = true;
+        return;
+    }
+
+    Start(loader, path);
+}
+
+// Drops the in-flight load, and any pending one, once it finishes.
+void
+TrackLoaderCancel(TrackLoader *loader) {
+    if (loader->running) {
+        loader->has_pending = false;
+        loader->discard = true;
+    }
+}
+
+// Call once per frame. Starts the pending request as soon as the in-flight
+// one finishes, discarding whatever it produced.
+TrackLoaderStatus
+TrackLoaderUpdate(TrackLoader *loader) {
+    TrackLoaderStatus status = atomic_load(&loader->status);
+
+    if (!loader->running || (!loader->has_pending && !loader->discard)) {
+        return status;
+    }
+
+    if (status != TrackLoaderStatus_READY &&
+        status != TrackLoaderStatus_FAILED) {
+        return status;
+    }
+
+    // The thread has already returned, so this doesn't wait.
+    ThreadJoin(loader->thread);
+
+    loader->running = false;
+
+    if (status == TrackLoaderStatus_READY) {
+        TrackClose(&loader->track);
+    }
+
+    if (!loader->has_pending) {
+        atomic_store(&loader->status, TrackLoaderStatus_IDLE);
+        return TrackLoaderStatus_IDLE;
+    }
+
+    loader->has_pending = false;
+    Start(loader, loader->pending);
+
+    return TrackLoaderStatus_OPENING;
+}
+
+// Hands over a finished load and returns the loader to idle. The caller owns
+// the track and must copy it out before the next request. Returns NULL if the
+// load failed; path still names the file either way.
+Track *
+TrackLoaderTake(TrackLoader *loader) {
+    TrackLoaderStatus status = atomic_load(&loader->status);
+
+    if (!loader->running || (status != TrackLoaderStatus_READY &&
+                             status != TrackLoaderStatus_FAILED)) {
+        return NULL;
+    }
+
+    ThreadJoin(loader->thread);
+    loader->running = false;
+
+    atomic_store(&loader->status, TrackLoaderStatus_IDLE);
+
+    if (status == TrackLoaderStatus_FAILED) {
+        return NULL;
+    }
+
+    return &loader->track;
+}
+
+B8
+TrackLoaderBusy(TrackLoader *loader) {
+    return loader->running;
+}
+
+F32
+TrackLoaderProgress(TrackLoader *loader) {
+    return atomic_load(&loader->progress);
+}
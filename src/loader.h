@@ -0,0 +1,59 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "arena.h"
+#include "defines.h"
+#include "thread.h"
+#include "track.h"
+
+// Bytes read ahead from the start of a track so the first decoder reads
+// after the head are served from the page cache.
+#define LOADER_PRIME_BYTES (4 * 1024 * 1024)
+
+typedef enum TrackLoaderStatus {
+    TrackLoaderStatus_IDLE = 0,
+    TrackLoaderStatus_OPENING,
+    TrackLoaderStatus_PRIMING,
+    TrackLoaderStatus_READY,
+    TrackLoaderStatus_FAILED,
+} TrackLoaderStatus;
+
+// Opens tracks on a background thread. The render thread polls it once per
+// frame and takes the track when it is ready, so it never waits on file I/O
+// or decoder setup.
+typedef struct TrackLoader {
+    Thread *thread;
+    B8      running;
+
+    _Atomic I32 status;
+    _Atomic F32 progress;
+
+    char  path[256];
+    Track track;
+
+    // Latest request that arrived while a load was in flight. It replaces the
+    // in-flight track once that finishes.
+    char pending[256];
+    B8   has_pending;
+
+    // Set when the in-flight track is no longer wanted.
+    B8 discard;
+} TrackLoader;
+
+void
+TrackLoaderInitialise(TrackLoader *loader, MemoryArena *arena);
+void
+TrackLoaderDestroy(TrackLoader *loader);
+void
+TrackLoaderRequest(TrackLoader *loader, const char *path);
+void
+TrackLoaderCancel(TrackLoader *loader);
+TrackLoaderStatus
+TrackLoaderUpdate(TrackLoader *loader);
+Track *
+TrackLoaderTake(TrackLoader *loader);
+B8
+TrackLoaderBusy(TrackLoader *loader);
+F32
+TrackLoaderProgress(TrackLoader *loader);
@@ -12,3 +12,7 @@ void
 LoopbackDestroy(LoopbackData *data);
 U32
 LoopbackDataSize();
+U32
+LoopbackSampleRate(LoopbackData *data);
+U32
+LoopbackChannels(LoopbackData *data);
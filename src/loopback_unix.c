@@ -1,7 +1,9 @@
 #include "loopback.h"
 
+#include "capture.h"
 #include "defines.h"
 #include "portaudio.h"
+#include "resampler.h"
 #include "state.h"
 #include <stdio.h>
 
@@ -16,6 +18,12 @@ typedef struct LoopbackAudioData {
     F32 right_phase;
 } LoopbackAudioData;
 
+typedef struct LoopbackData {
+    PaStream *stream;
+
+    Resampler resampler;
+} LoopbackData;
+
 static int
 LoopbackCallback(const void                     *input_buffer,
                  void                           *output_buffer,
@@ -25,6 +33,8 @@ LoopbackCallback(const void                     *input_buffer,
                  void                           *user_data) {
     State *state = (State *)user_data;
 
+    RealtimePromoteAudio(state->realtime);
+
     if (state->loopback) {
         const F32(*frame_data)[2] = input_buffer;
 
@@ -34,19 +44,22 @@ LoopbackCallback(const void                     *input_buffer,
             if (frame_data[i][0] != 0.0f) {
                 state->zero_frequencies = false;
             }
-
-            StatePushFrame(frame_data[i][0], state->samples, SAMPLE_COUNT);
         }
+
+        StatePushResampled(&state->loopback_data->resampler,
+                           (F32 *)input_buffer, 2, frames_per_buffer,
+                           &state->ring);
+
+        CaptureWrite(state->capture, input_buffer, 2, frames_per_buffer);
     }
     return 0;
 }
 
-typedef struct LoopbackData {
-    PaStream *stream;
-} LoopbackData;
-
 void
 LoopbackInitialise(LoopbackData *data, void *state) {
+    ResamplerInitialise(&data->resampler, SAMPLE_RATE,
+                        ((State *)state)->analysis_rate);
+
     PaError err = Pa_Initialize();
     DumpError(err);
 
@@ -73,6 +86,16 @@ LoopbackDataSize() {
     return sizeof(LoopbackData);
 }
 
+U32
+LoopbackSampleRate(LoopbackData *data) {
+    return SAMPLE_RATE;
+}
+
+U32
+LoopbackChannels(LoopbackData *data) {
+    return 2;
+}
+
 static void
 DumpError(PaError err) {
     if (err != paNoError) {
@@ -1,4 +1,6 @@
 #include "loopback.h"
+#include "capture.h"
+#include "resampler.h"
 #include "state.h"
 
 #include "defines.h"
@@ -10,6 +12,8 @@
 typedef struct LoopbackData {
     ma_device device;
     B8        is_initialised;
+
+    Resampler resampler;
 } LoopbackData;
 
 void
@@ -21,12 +25,15 @@ LoopbackDataCallback(ma_device  *device,
 
     State *state = (State *)device->pUserData;
 
+    RealtimePromoteAudio(state->realtime);
+
     if (state->loopback) {
-        const F32(*frame_data)[device->capture.channels] = input;
+        StatePushResampled(&state->loopback_data->resampler, (F32 *)input,
+                           device->capture.channels, frame_count,
+                           &state->ring);
 
-        for (U32 i = 0; i < frame_count; ++i) {
-            StatePushFrame(frame_data[i][0], state->samples, SAMPLE_COUNT);
-        }
+        CaptureWrite(state->capture, input, device->capture.channels,
+                     frame_count);
     }
 }
 
@@ -46,6 +53,9 @@ LoopbackInitialise(LoopbackData *data, void *state) {
     device_config.dataCallback = LoopbackDataCallback;
     device_config.pUserData = state;
 
+    ResamplerInitialise(&data->resampler, device_config.sampleRate,
+                        ((State *)state)->analysis_rate);
+
     ma_result res =
         ma_device_init_ex(backends, sizeof(backends) / sizeof(backends[0]),
                           NULL, &device_config, &data->device);
@@ -77,3 +87,13 @@ U32
 LoopbackDataSize() {
     return sizeof(LoopbackData);
 }
+
+U32
+LoopbackSampleRate(LoopbackData *data) {
+    return data->device.sampleRate;
+}
+
+U32
+LoopbackChannels(LoopbackData *data) {
+    return data->device.capture.channels;
+}
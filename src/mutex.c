@@ -15,7 +15,38 @@ MutexLock(Mutex *mutex) {
     pthread_mutex_lock(&mutex->mutex);
 }
 
+// Takes the mutex only if nobody holds it. Returns whether it was taken.
+B8
+MutexTryLock(Mutex *mutex) {
+    return pthread_mutex_trylock(&mutex->mutex) == 0;
+}
+
 void
 MutexUnlock(Mutex *mutex) {
     pthread_mutex_unlock(&mutex->mutex);
 }
+
+void
+ConditionCreate(Condition *condition) {
+    pthread_cond_init(&condition->cond, NULL);
+}
+
+void
+ConditionDestroy(Condition *condition) {
+    pthread_cond_destroy(&condition->cond);
+}
+
+void
+ConditionWait(Condition *condition, Mutex *mutex) {
+    pthread_cond_wait(&condition->cond, &mutex->mutex);
+}
+
+void
+ConditionSignal(Condition *condition) {
+    pthread_cond_signal(&condition->cond);
+}
+
+void
+ConditionBroadcast(Condition *condition) {
+    pthread_cond_broadcast(&condition->cond);
+}
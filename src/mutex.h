@@ -2,11 +2,24 @@
 
 #include <pthread.h>
 
+#include "defines.h"
+
 typedef struct Mutex {
     pthread_mutex_t mutex;
 } Mutex;
 
+typedef struct Condition {
+    pthread_cond_t cond;
+} Condition;
+
 void MutexCreate(Mutex *mutex);
 void MutexDestroy(Mutex *mutex);
 void MutexLock(Mutex *mutex);
+B8   MutexTryLock(Mutex *mutex);
 void MutexUnlock(Mutex *mutex);
+
+void ConditionCreate(Condition *condition);
+void ConditionDestroy(Condition *condition);
+void ConditionWait(Condition *condition, Mutex *mutex);
+void ConditionSignal(Condition *condition);
+void ConditionBroadcast(Condition *condition);
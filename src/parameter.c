@@ -2,96 +2,156 @@
 
 #include <string.h>
 
+#include "alloc.h"
 #include "hashmap.h"
+#include "intern.h"
 
+// Names are interned, so they are equal only if their pointers are.
 static I32
 ParameterCompare(const void *a, const void *b, void *udata) {
     (void)(udata);
 
-    Parameter *pa = (Parameter *)a;
-    Parameter *pb = (Parameter *)b;
-    return strcmp(pa->name, pb->name);
+    ParameterInfo *pa = (ParameterInfo *)a;
+    ParameterInfo *pb = (ParameterInfo *)b;
+    return pa->name != pb->name;
 }
 
 static U64
 ParameterHash(const void *item, U64 seed0, U64 seed1) {
-    Parameter *pitem = (Parameter *)item;
+    (void)(seed0);
+    (void)(seed1);
 
-    return hashmap_sip(pitem->name, strlen(pitem->name), seed0, seed1);
+    return ((ParameterInfo *)item)->name->hash;
 }
 
-HM_Hashmap *
-ParameterCreate() {
-    return hashmap_new(sizeof(Parameter), 0, 0, 0, ParameterHash,
-                       ParameterCompare, NULL, NULL);
+void
+ParametersInitialise(Parameters *params) {
+    memset(params, 0, sizeof(Parameters));
+
+    params->info = hashmap_dense_new_with_allocator(
+        AllocHashmapMalloc, AllocHashmapRealloc, AllocHashmapFree,
+        sizeof(ParameterInfo), 0, 0, 0, ParameterHash, ParameterCompare, NULL,
+        NULL);
 }
 
 void
-ParameterDestroy(HM_Hashmap *params) {
-    hashmap_free(params);
-};
+ParametersDestroy(Parameters *params) {
+    hashmap_dense_free(params->info);
 
-B8
-ParameterIter(HM_Hashmap *params, U32 *iter, Parameter **parameter) {
-    return hashmap_iter(params, iter, (void **)parameter);
+    AllocFree(AllocTag_PARAMETER, params->values);
 }
 
-Parameter *
-ParameterGet(HM_Hashmap *params, const char *name) {
-    return (Parameter *)hashmap_get(params, &(Parameter){.name = name});
+static ParameterInfo *
+Info(Parameters *params, ParameterHandle handle) {
+    return (ParameterInfo *)hashmap_dense_at(params->info, handle);
 }
 
-F32
-ParameterGetValue(HM_Hashmap *params, const char *name) {
-    Parameter *param =
-        ((Parameter *)hashmap_get(params, &(Parameter){.name = name}));
+static ParameterHandle
+Find(Parameters *params, Intern name) {
+    const ParameterInfo *info = hashmap_dense_get_with_hash(
+        params->info, &(ParameterInfo){.name = name}, name->hash);
 
-    if (param) {
-        return param->value;
+    return info ? hashmap_dense_position(params->info, info) : PARAMETER_NONE;
+}
+
+// Adds a parameter, or resets the value and range of the one already
+// registered under name.
+ParameterHandle
+ParameterRegister(Parameters *params,
+                  const char *name,
+                  F32         value,
+                  F32         min,
+                  F32         max) {
+    Intern          interned = InternGet(name);
+    ParameterHandle handle = Find(params, interned);
+
+    if (handle == PARAMETER_NONE) {
+        const ParameterInfo *info = hashmap_dense_set_with_hash(
+            params->info, &(ParameterInfo){.name = interned}, interned->hash);
+
+        if (!info) {
+            return PARAMETER_NONE;
+        }
+
+        handle = hashmap_dense_position(params->info, info);
+
+        // Handles are positions, so moving the values leaves them valid.
+        if (handle >= params->capacity) {
+            params->capacity = params->capacity ? params->capacity * 2
+                                                : PARAMETER_INITIAL_CAPACITY;
+            params->values = AllocRealloc(AllocTag_PARAMETER, params->values,
+                                          params->capacity * sizeof(F32));
+        }
     }
 
-    return 0.0f;
+    ParameterSet(params, handle, value, min, max);
+
+    return handle;
 }
 
-_Parameter
-ParameterSet(HM_Hashmap *params, Parameter *param) {
-    hashmap_set(params, param);
+// Names that were never interned can't belong to a parameter, so unknown
+// names don't grow the intern table.
+ParameterHandle
+ParameterFind(Parameters *params, const char *name) {
+    Intern interned = InternFind(name);
 
-    return ParameterGeneratePtr(params, param->name);
+    return interned ? Find(params, interned) : PARAMETER_NONE;
 }
 
-void
-ParameterSetValue(HM_Hashmap *params, const char *name, F32 value) {
-    Parameter *prev = ParameterGet(params, name);
-
-    if (prev) {
-        ParameterSet(params, &(Parameter){.name = name,
-                                          .value = value,
-                                          .min = prev->min,
-                                          .max = prev->max});
-    }
+B8
+ParameterValid(Parameters *params, ParameterHandle handle) {
+    return handle < hashmap_dense_count(params->info);
 }
 
 U32
-ParameterCount(HM_Hashmap *params) {
-    return hashmap_count(params);
+ParameterCount(Parameters *params) {
+    return hashmap_dense_count(params->info);
+}
+
+F32
+ParameterGetValue(Parameters *params, ParameterHandle handle) {
+    if (!ParameterValid(params, handle)) {
+        return 0.0f;
+    }
+
+    return params->values[handle];
 }
 
 void
-_ParameterSetValue(_Parameter param, F32 value) {
-    ParameterSetValue(param.parameters, param.name, value);
+ParameterSetValue(Parameters *params, ParameterHandle handle, F32 value) {
+    if (ParameterValid(params, handle)) {
+        params->values[handle] = value;
+    }
 }
 
-F32
-_ParameterGetValue(_Parameter param) {
-    return ParameterGetValue(param.parameters, param.name);
+void
+ParameterSet(Parameters     *params,
+             ParameterHandle handle,
+             F32             value,
+             F32             min,
+             F32             max) {
+    if (!ParameterValid(params, handle)) {
+        return;
+    }
+
+    ParameterInfo *info = Info(params, handle);
+
+    params->values[handle] = value;
+    info->min = min;
+    info->max = max;
 }
 
-_Parameter
-ParameterGeneratePtr(HM_Hashmap *params, const char *name) {
-    _Parameter param = (_Parameter){.parameters = params};
+const char *
+ParameterName(Parameters *params, ParameterHandle handle) {
+    return Info(params, handle)->name->text;
+}
 
-    memcpy(param.name, name, strlen(name) + 1);
+F32
+ParameterMin(Parameters *params, ParameterHandle handle) {
+    return Info(params, handle)->min;
+}
 
-    return param;
+F32
+ParameterMax(Parameters *params, ParameterHandle handle) {
+    return Info(params, handle)->max;
 }
@@ -2,40 +2,66 @@
 
 #include "defines.h"
 #include "hashmap.h"
+#include "intern.h"
 
-typedef struct Parameter {
-    const char *name;
-    F32         value, min, max;
-} Parameter;
+// Slots reserved up front; the registry grows past this as needed.
+#define PARAMETER_INITIAL_CAPACITY 32
 
-typedef struct _Parameter {
-    char        name[512];
-    HM_Hashmap *parameters;
-} _Parameter;
+// Index of a parameter in its registry. Handles never change once given out,
+// however much the registry grows.
+typedef U32 ParameterHandle;
 
-HM_Hashmap *
-ParameterCreate();
+#define PARAMETER_NONE ((ParameterHandle)-1)
+
+typedef struct ParameterInfo {
+    Intern name;
+    F32    min, max;
+} ParameterInfo;
+
+// Parameters in registration order. Names are only looked up when a
+// parameter is registered or found; everything else goes straight to an
+// index. Values sit in an array of their own, as they are what frames read.
+typedef struct Parameters {
+    F32 *values;
+    U32  capacity;
+
+    // Keyed by interned name, in registration order, so a handle is a
+    // parameter's position. Parameters are never removed, so positions
+    // never move.
+    HM_Dense *info;
+} Parameters;
+
+void
+ParametersInitialise(Parameters *params);
 void
-ParameterDestroy(HM_Hashmap *params);
+ParametersDestroy(Parameters *params);
+
+ParameterHandle
+ParameterRegister(Parameters *params,
+                  const char *name,
+                  F32         value,
+                  F32         min,
+                  F32         max);
+ParameterHandle
+ParameterFind(Parameters *params, const char *name);
 B8
-ParameterIter(HM_Hashmap *params, U32 *iter, Parameter **parameter);
+ParameterValid(Parameters *params, ParameterHandle handle);
+U32
+ParameterCount(Parameters *params);
 
-Parameter *
-ParameterGet(HM_Hashmap *params, const char *name);
 F32
-ParameterGetValue(HM_Hashmap *params, const char *name);
-
-_Parameter
-ParameterSet(HM_Hashmap *params, Parameter *param);
+ParameterGetValue(Parameters *params, ParameterHandle handle);
 void
-ParameterSetValue(HM_Hashmap *params, const char *name, F32 value);
-U32
-ParameterCount(HM_Hashmap *params);
+ParameterSetValue(Parameters *params, ParameterHandle handle, F32 value);
 void
-_ParameterSetValue(_Parameter param, F32 value);
-
+ParameterSet(Parameters     *params,
+             ParameterHandle handle,
+             F32             value,
+             F32             min,
+             F32             max);
+const char *
+ParameterName(Parameters *params, ParameterHandle handle);
 F32
-_ParameterGetValue(_Parameter param);
-
-_Parameter
-ParameterGeneratePtr(HM_Hashmap *params, const char *name);
+ParameterMin(Parameters *params, ParameterHandle handle);
+F32
+ParameterMax(Parameters *params, ParameterHandle handle);
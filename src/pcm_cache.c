@@ -0,0 +1,312 @@
+#include "pcm_cache.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "arena.h"
+#include "decoder.h"
+#include "defines.h"
+#include "filesystem.h"
+#include "hashmap.h"
+#include "lmath.h"
+#include "resampler.h"
+#include "thread.h"
+
+#define PCM_CACHE_HASH_CHUNK (1 << 20)
+
+// Share of the progress bar covered by hashing the source file.
+#define PCM_CACHE_HASH_SHARE 0.1f
+
+static B8
+HashFile(PcmCache *cache, U64 *key) {
+    U64       size;
+    const U8 *data = FSMapFile(cache->path, &size);
+
+    if (!data) {
+        return false;
+    }
+
+    U64 hash = size;
+
+    for (U64 i = 0; i < size; i += PCM_CACHE_HASH_CHUNK) {
+        U32 len = MinU64(PCM_CACHE_HASH_CHUNK, size - i);
+        hash = hashmap_xxhash3(data + i, len, hash, 0);
+
+        atomic_store(&cache->progress,
+                     PCM_CACHE_HASH_SHARE * (i + len) / (F32)size);
+    }
+
+    FSUnmapFile(data, size);
+
+    *key = hash;
+
+    return true;
+}
+
+static void
+Unmap(PcmCache *cache) {
+    FSUnmapFile(cache->map, cache->map_size);
+
+    cache->map = NULL;
+    cache->map_size = 0;
+    cache->samples = NULL;
+    cache->frame_count = 0;
+}
+
+// Maps file if it is a complete cache for the current key and rate.
+static B8
+Map(PcmCache *cache, const char *file) {
+    cache->map = FSMapFile(file, &cache->map_size);
+
+    if (!cache->map) {
+        return false;
+    }
+
+    const PcmCacheHeader *header = cache->map;
+
+    if (cache->map_size < sizeof(PcmCacheHeader) ||
+        header->magic != PCM_CACHE_MAGIC ||
+        header->version != PCM_CACHE_VERSION ||
+        header->sample_rate != cache->sample_rate || header->channels != 1 ||
+        header->key != cache->key ||
+        cache->map_size !=
+            sizeof(PcmCacheHeader) + header->frame_count * sizeof(I16)) {
+        Unmap(cache);
+        return false;
+    }
+
+    cache->samples = (const I16 *)(header + 1);
+    cache->frame_count = header->frame_count;
+
+    return true;
+}
+
+// Decodes channel 0 of the whole track into file. Writes go to a temporary
+// file that is only renamed into place once complete, so a crash never
+// leaves a truncated cache behind.
+static B8
+Build(PcmCache *cache, const char *file) {
+    Decoder *decoder = &cache->decoder;
+
+    if (!DecoderOpen(decoder, cache->path)) {
+        return false;
+    }
+
+    char tmp[600];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", file);
+
+    FILE *fptr = fopen(tmp, "wb");
+
+    if (!fptr) {
+        DecoderClose(decoder);
+        return false;
+    }
+
+    // Large buffered writes; the cache can run to hundreds of megabytes.
+    setvbuf(fptr, NULL, _IOFBF, 1 << 20);
+
+    PcmCacheHeader header = {.magic = PCM_CACHE_MAGIC,
+                             .version = PCM_CACHE_VERSION,
+                             .sample_rate = cache->sample_rate,
+                             .channels = 1,
+                             .key = cache->key};
+
+    fwrite(&header, sizeof(header), 1, fptr);
+
+    ResamplerInitialise(&cache->resampler, decoder->sample_rate,
+                        cache->sample_rate);
+
+    U32 chunk = MinU32(ResamplerMaxInput(&cache->resampler, RESAMPLER_BLOCK),
+                       RESAMPLER_BLOCK);
+    U64 decoded = 0;
+    B8  ok = true;
+
+    for (;;) {
+        if (atomic_load(&cache->cancelled)) {
+            ok = false;
+            break;
+        }
+
+        U32 n = DecoderRead(decoder, cache->scratch, chunk);
+
+        if (n == 0) {
+            break;
+        }
+
+        U32 count = ResamplerProcess(&cache->resampler, cache->scratch,
+                                     decoder->channels, n, cache->resampled);
+
+        for (U32 i = 0; i < count; ++i) {
+            cache->quantised[i] =
+                ClampF32(cache->resampled[i], -1.0f, 1.0f) * 32767.0f;
+        }
+
+        if (fwrite(cache->quantised, sizeof(I16), count, fptr) != count) {
+            ok = false;
+            break;
+        }
+
+        header.frame_count += count;
+        decoded += n;
+
+        if (decoder->frame_count > 0) {
+            atomic_store(&cache->progress,
+                         PCM_CACHE_HASH_SHARE +
+                             (1.0f - PCM_CACHE_HASH_SHARE) * decoded /
+                                 (F32)decoder->frame_count);
+        }
+    }
+
+    DecoderClose(decoder);
+
+    fseek(fptr, 0, SEEK_SET);
+    fwrite(&header, sizeof(header), 1, fptr);
+
+    if (fclose(fptr) != 0) {
+        ok = false;
+    }
+
+    if (!ok || rename(tmp, file) != 0) {
+        remove(tmp);
+        return false;
+    }
+
+    return true;
+}
+
+static void *
+CacheThread(void *data) {
+    PcmCache *cache = data;
+
+    if (!HashFile(cache, &cache->key)) {
+        atomic_store(&cache->status, PcmCacheStatus_FAILED);
+        return NULL;
+    }
+
+    snprintf(cache->file, sizeof(cache->file), "%s/%016llx-%u.pcm",
+             cache->directory, (unsigned long long)cache->key,
+             cache->sample_rate);
+
+    if (!Map(cache, cache->file)) {
+        atomic_store(&cache->status, PcmCacheStatus_DECODING);
+
+        if (!Build(cache, cache->file) || !Map(cache, cache->file)) {
+            atomic_store(&cache->status, PcmCacheStatus_FAILED);
+            return NULL;
+        }
+    }
+
+    atomic_store(&cache->progress, 1.0f);
+    atomic_store(&cache->status, PcmCacheStatus_READY);
+
+    return NULL;
+}
+
+static void
+Start(PcmCache *cache, const char *path, U32 sample_rate) {
+    Unmap(cache);
+
+    strcpy(cache->path, path);
+    cache->sample_rate = sample_rate;
+
+    // Built here because TextFormat isn't safe off the main thread.
+    FSGetApolloDirectory(cache->directory);
+    strcat(cache->directory, "/pcm");
+
+    atomic_store(&cache->progress, 0.0f);
+    atomic_store(&cache->status, PcmCacheStatus_HASHING);
+
+    cache->running = true;
+    ThreadCreate(cache->thread, CacheThread, cache);
+}
+
+void
+PcmCacheInitialise(PcmCache *cache, MemoryArena *arena) {
+    memset(cache, 0, sizeof(PcmCache));
+
+    cache->thread = ThreadAlloc(arena);
+}
+
+void
+PcmCacheDestroy(PcmCache *cache) {
+    atomic_store(&cache->cancelled, true);
+
+    if (cache->running) {
+        ThreadJoin(cache->thread);
+    }
+
+    Unmap(cache);
+}
+
+// Starts building or opening the cache for path. Does nothing if it is
+// already the current one.
+void
+PcmCacheRequest(PcmCache *cache, const char *path, U32 sample_rate) {
+    if (cache->running) {
+        strcpy(cache->pending, path);
+        cache->has_pending = true;
+        return;
+    }
+
+    if (atomic_load(&cache->status) == PcmCacheStatus_READY &&
+        cache->sample_rate == sample_rate && strcmp(cache->path, path) == 0) {
+        return;
+    }
+
+    Start(cache, path, sample_rate);
+}
+
+// Call once per frame. Reaps the build thread and starts the latest pending
+// request.
+PcmCacheStatus
+PcmCacheUpdate(PcmCache *cache) {
+    PcmCacheStatus status = atomic_load(&cache->status);
+
+    if (!cache->running || (status != PcmCacheStatus_READY &&
+                            status != PcmCacheStatus_FAILED)) {
+        return status;
+    }
+
+    ThreadJoin(cache->thread);
+    cache->running = false;
+
+    if (cache->has_pending) {
+        cache->has_pending = false;
+        PcmCacheRequest(cache, cache->pending, cache->sample_rate);
+    }
+
+    return atomic_load(&cache->status);
+}
+
+B8
+PcmCacheReady(PcmCache *cache, const char *path) {
+    return !cache->running &&
+           atomic_load(&cache->status) == PcmCacheStatus_READY &&
+           strcmp(cache->path, path) == 0;
+}
+
+F32
+PcmCacheProgress(PcmCache *cache) {
+    return atomic_load(&cache->progress);
+}
+
+// Converts count frames starting at frame to float. Frames outside the track
+// read as silence. Returns the number of frames that were inside it.
+U32
+PcmCacheRead(PcmCache *cache, I64 frame, F32 *out, U32 count) {
+    U32 inside = 0;
+
+    for (U32 i = 0; i < count; ++i) {
+        I64 f = frame + i;
+
+        if (f < 0 || f >= (I64)cache->frame_count) {
+            out[i] = 0.0f;
+            continue;
+        }
+
+        out[i] = cache->samples[f] / 32768.0f;
+        inside++;
+    }
+
+    return inside;
+}
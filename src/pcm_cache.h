@@ -0,0 +1,79 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "arena.h"
+#include "decoder.h"
+#include "defines.h"
+#include "resampler.h"
+#include "thread.h"
+
+#define PCM_CACHE_MAGIC 0x4d435041 // "APCM"
+#define PCM_CACHE_VERSION 1
+
+typedef struct PcmCacheHeader {
+    U32 magic;
+    U32 version;
+    U32 sample_rate;
+    U32 channels;
+    U64 frame_count;
+    U64 key;
+} PcmCacheHeader;
+
+typedef enum PcmCacheStatus {
+    PcmCacheStatus_IDLE = 0,
+    PcmCacheStatus_HASHING,
+    PcmCacheStatus_DECODING,
+    PcmCacheStatus_READY,
+    PcmCacheStatus_FAILED,
+} PcmCacheStatus;
+
+// Whole-track audio, decoded once in the background to mono int16 at the
+// analysis rate and kept in ~/.config/apollo/pcm. The file is named after a
+// hash of the track's contents and mapped rather than read, so any region can
+// be fetched instantly while only the pages touched stay resident.
+typedef struct PcmCache {
+    Thread *thread;
+    B8      running;
+
+    _Atomic I32 status;
+    _Atomic F32 progress;
+    _Atomic I32 cancelled;
+
+    char path[256];
+    char directory[512];
+    U32  sample_rate;
+    U64  key;
+
+    // Valid once status is READY.
+    char        file[600];
+    const void *map;
+    U64         map_size;
+    const I16  *samples;
+    U64         frame_count;
+
+    char pending[256];
+    B8   has_pending;
+
+    // Only used by the build thread.
+    Decoder   decoder;
+    Resampler resampler;
+    F32       scratch[RESAMPLER_BLOCK * DECODER_MAX_CHANNELS];
+    F32       resampled[RESAMPLER_BLOCK];
+    I16       quantised[RESAMPLER_BLOCK];
+} PcmCache;
+
+void
+PcmCacheInitialise(PcmCache *cache, MemoryArena *arena);
+void
+PcmCacheDestroy(PcmCache *cache);
+void
+PcmCacheRequest(PcmCache *cache, const char *path, U32 sample_rate);
+PcmCacheStatus
+PcmCacheUpdate(PcmCache *cache);
+B8
+PcmCacheReady(PcmCache *cache, const char *path);
+F32
+PcmCacheProgress(PcmCache *cache);
+U32
+PcmCacheRead(PcmCache *cache, I64 frame, F32 *out, U32 count);
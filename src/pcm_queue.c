@@ -0,0 +1,204 @@
+#include "pcm_queue.h"
+
+#include <string.h>
+
+#include "defines.h"
+#include "lmath.h"
+
+// Only safe while neither side is running.
+void
+PcmQueueReset(PcmQueue *queue, U32 channels) {
+    queue->channels = channels;
+
+    atomic_store(&queue->written, 0);
+    atomic_store(&queue->read, 0);
+    atomic_store(&queue->skip_to, 0);
+}
+
+// Producer side. Frames that can be written without overtaking the reader.
+U32
+PcmQueueFree(PcmQueue *queue) {
+    U64 written = atomic_load_explicit(&queue->written, memory_order_relaxed);
+    U64 read = atomic_load_explicit(&queue->read, memory_order_acquire);
+    U64 skip_to = atomic_load_explicit(&queue->skip_to, memory_order_relaxed);
+
+    return PCM_QUEUE_CAPACITY - (written - MaxU64(read, skip_to));
+}
+
+// Producer side. count must not exceed PcmQueueFree.
+void
+PcmQueueWrite(PcmQueue *queue, const F32 *frames, U32 count) {
+    U64 written = atomic_load_explicit(&queue->written, memory_order_relaxed);
+    U32 start = written % PCM_QUEUE_CAPACITY;
+    U32 first = MinU32(count, PCM_QUEUE_CAPACITY - start);
+    U32 channels = queue->channels;
+
+    memcpy(queue->frames + start * channels, frames,
+           first * channels * sizeof(F32));
+    memcpy(queue->frames, frames + first * channels,
+           (count - first) * channels * sizeof(F32));
+
+    atomic_store_explicit(&queue->written, written + count,
+                          memory_order_release);
+}
+
+// Producer side. Everything written so far will be skipped by the reader.
+void
+PcmQueueFlush(PcmQueue *queue) {
+    atomic_store_explicit(
+        &queue->skip_to,
+        atomic_load_explicit(&queue->written, memory_order_relaxed),
+        memory_order_release);
+}
+
+// Consumer side. Returns the number of frames read, which is less than count
+// if the producer has fallen behind.
+U32
+PcmQueueRead(PcmQueue *queue, F32 *frames, U32 count) {
+    U64 read = atomic_load_explicit(&queue->read, memory_order_relaxed);
+    U64 skip_to = atomic_load_explicit(&queue->skip_to, memory_order_acquire);
+    U64 written = atomic_load_explicit(&queue->written, memory_order_acquire);
+
+    read = MaxU64(read, skip_to);
+    count = MinU32(count, written - read);
+
+    U32 start = read % PCM_QUEUE_CAPACITY;
+    U32 first = MinU32(count, PCM_QUEUE_CAPACITY - start);
+    U32 channels = queue->channels;
+
+    memcpy(frames, queue->frames + start * channels,
+           first * channels * sizeof(F32));
+    memcpy(frames + first * channels, queue->frames,
+           (count - first) * channels * sizeof(F32));
+
+    atomic_store_explicit(&queue->read, read + count, memory_order_release);
+
+    return count;
+}
+
+U64
+PcmQueueWritten(PcmQueue *queue) {
+    return atomic_load_explicit(&queue->written, memory_order_acquire);
+}
+
+U64
+PcmQueueReadPosition(PcmQueue *queue) {
+    return atomic_load_explicit(&queue->read, memory_order_acquire);
+}
+
+//==============================================================================
+// Benchmark
+//
+// $ cc -DPCM_QUEUE_BENCH -O2 -Ilib/raylib/src src/pcm_queue.c src/lmath.c
+// $ ./a.out
+//
+// Hands frames one at a time from one thread to another using the queue's
+// protocol, first with both positions on one cache line as they used to be,
+// then split as they are now. Small transfers are where sharing hurts most.
+//==============================================================================
+#ifdef PCM_QUEUE_BENCH
+
+#include <pthread.h>
+#include <stdio.h>
+#include <time.h>
+#include <unistd.h>
+
+#define BENCH_FRAMES (1 << 22)
+#define BENCH_CAPACITY 1024
+
+typedef struct PackedPositions {
+    _Atomic U64 written;
+    _Atomic U64 read;
+} PackedPositions;
+
+typedef struct SplitPositions {
+    _Alignas(CACHE_LINE_SIZE) _Atomic U64 written;
+    _Alignas(CACHE_LINE_SIZE) _Atomic U64 read;
+} SplitPositions;
+
+static F32 bench_frames[BENCH_CAPACITY];
+static F32 bench_sum;
+
+#define BENCH_SIDES(type)                                                      \
+    static void *type##Produce(void *data) {                                   \
+        type *positions = data;                                                \
+                                                                               \
+        for (U64 i = 0; i < BENCH_FRAMES; ++i) {                               \
+            while (i - atomic_load_explicit(&positions->read,                  \
+                                            memory_order_acquire) >=           \
+                   BENCH_CAPACITY) {                                           \
+            }                                                                  \
+                                                                               \
+            bench_frames[i % BENCH_CAPACITY] = (F32)i;                         \
+            atomic_store_explicit(&positions->written, i + 1,                  \
+                                  memory_order_release);                       \
+        }                                                                      \
+                                                                               \
+        return NULL;                                                           \
+    }                                                                          \
+                                                                               \
+    static void *type##Consume(void *data) {                                   \
+        type *positions = data;                                                \
+        F32   sum = 0.0f;                                                      \
+                                                                               \
+        for (U64 i = 0; i < BENCH_FRAMES; ++i) {                               \
+            while (atomic_load_explicit(&positions->written,                   \
+                                        memory_order_acquire) == i) {          \
+            }                                                                  \
+                                                                               \
+            sum += bench_frames[i % BENCH_CAPACITY];                           \
+            atomic_store_explicit(&positions->read, i + 1,                     \
+                                  memory_order_release);                       \
+        }                                                                      \
+                                                                               \
+        bench_sum += sum;                                                      \
+                                                                               \
+        return NULL;                                                           \
+    }
+
+BENCH_SIDES(PackedPositions)
+BENCH_SIDES(SplitPositions)
+
+static F64
+Now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static F64
+Run(void *(*produce)(void *), void *(*consume)(void *), void *positions) {
+    pthread_t producer, consumer;
+
+    F64 start = Now();
+
+    pthread_create(&producer, NULL, produce, positions);
+    pthread_create(&consumer, NULL, consume, positions);
+    pthread_join(producer, NULL);
+    pthread_join(consumer, NULL);
+
+    return (Now() - start) * 1e9 / BENCH_FRAMES;
+}
+
+I32
+main(void) {
+    // Both sides spin, so they need a core each.
+    if (sysconf(_SC_NPROCESSORS_ONLN) < 2) {
+        printf("needs at least two cores\n");
+        return 0;
+    }
+
+    static PackedPositions packed;
+    static SplitPositions  split;
+
+    F64 before = Run(PackedPositionsProduce, PackedPositionsConsume, &packed);
+    F64 after = Run(SplitPositionsProduce, SplitPositionsConsume, &split);
+
+    printf("shared line: %6.2f ns/frame\n", before);
+    printf("split lines: %6.2f ns/frame (%.2fx)\n", after, before / after);
+
+    return bench_sum == 0.0f;
+}
+
+#endif
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "defines.h"
+
+#define PCM_QUEUE_CAPACITY (1 << 15)
+#define PCM_QUEUE_MAX_CHANNELS 2
+
+// Single producer, single consumer queue of interleaved float frames. Neither
+// side ever blocks, so the consumer can be an audio callback.
+//
+// Each side's position is on a cache line of its own, so advancing it
+// doesn't take the line away from the other side in the middle of a copy.
+typedef struct PcmQueue {
+    // Producer side.
+    _Alignas(CACHE_LINE_SIZE) _Atomic U64 written;
+
+    // The consumer skips ahead to this frame before reading. Lets the
+    // producer drop queued audio without touching the read position.
+    _Atomic U64 skip_to;
+
+    U32 channels;
+
+    // Consumer side.
+    _Alignas(CACHE_LINE_SIZE) _Atomic U64 read;
+
+    _Alignas(CACHE_LINE_SIZE) F32
+        frames[PCM_QUEUE_CAPACITY * PCM_QUEUE_MAX_CHANNELS];
+} PcmQueue;
+
+void
+PcmQueueReset(PcmQueue *queue, U32 channels);
+U32
+PcmQueueFree(PcmQueue *queue);
+void
+PcmQueueWrite(PcmQueue *queue, const F32 *frames, U32 count);
+void
+PcmQueueFlush(PcmQueue *queue);
+U32
+PcmQueueRead(PcmQueue *queue, F32 *frames, U32 count);
+U64
+PcmQueueWritten(PcmQueue *queue);
+U64
+PcmQueueReadPosition(PcmQueue *queue);
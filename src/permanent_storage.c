@@ -1,11 +1,108 @@
+#include "permanent_storage.h"
+
 #include "arena.h"
 
 #include "defines.h"
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <sys/mman.h>
+#endif
+
+// Parses a byte count with an optional K, M or G suffix.
+static U64
+ParseSize(const char *text) {
+    char *end;
+    U64   size = strtoull(text, &end, 10);
+
+    switch (*end) {
+    case 'g':
+    case 'G':
+        size *= 1024;
+        // Fall through.
+    case 'm':
+    case 'M':
+        size *= 1024;
+        // Fall through.
+    case 'k':
+    case 'K':
+        size *= 1024;
+    default:
+        break;
+    }
+
+    return size;
+}
+
+PermanentStorageConfig PermanentStorageGetConfig() {
+    PermanentStorageConfig config = {.size = PERMANENT_STORAGE_SIZE};
+
+    const char *size = getenv("APOLLO_ARENA_SIZE");
+    if (size && ParseSize(size) > 0) {
+        config.size = ParseSize(size);
+    }
+
+    const char *huge_pages = getenv("APOLLO_HUGE_PAGES");
+    config.huge_pages = huge_pages && strcmp(huge_pages, "0") != 0;
+
+    return config;
+}
+
+// Reserves config.size bytes of address space without backing it. Nothing
+// can be touched until it is committed.
+void *PermanentStorageInit(PermanentStorageConfig config) {
+#if defined(_WIN32)
+    void *data = VirtualAlloc(NULL, config.size, MEM_RESERVE, PAGE_NOACCESS);
+#else
+    void *data = mmap(NULL, config.size, PROT_NONE,
+                      MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+
+    if (data == MAP_FAILED) {
+        data = NULL;
+    }
+
+#if defined(MADV_HUGEPAGE)
+    if (data && config.huge_pages &&
+        madvise(data, config.size, MADV_HUGEPAGE) != 0) {
+        printf("Transparent huge pages are unavailable.\n");
+    }
+#endif
+#endif
+
+    if (!data) {
+        fprintf(stderr, "ERROR: could not reserve %llu bytes.\n",
+                (unsigned long long)config.size);
+    }
 
-void *PermanentStorageInit(U32 size) { return malloc(size); }
+    return data;
+}
+
+// Backs a page-aligned range of reserved storage with zeroed memory.
+B8 PermanentStorageCommit(void *data, U64 size) {
+#if defined(_WIN32)
+    return VirtualAlloc(data, size, MEM_COMMIT, PAGE_READWRITE) != NULL;
+#else
+    return mprotect(data, size, PROT_READ | PROT_WRITE) == 0;
+#endif
+}
+
+void PermanentStorageDestroy(void *permanent_storage, U64 size) {
+#if defined(_WIN32)
+    VirtualFree(permanent_storage, 0, MEM_RELEASE);
+#else
+    munmap(permanent_storage, size);
+#endif
+}
 
-void PermanentStorageDestroy(void *permanent_storage) {
-    free(permanent_storage);
+// Keeps the pages covering data resident so touching them never faults.
+// Usually limited to a few megabytes without privileges.
+B8 PermanentStorageLock(void *data, U64 size) {
+#if defined(_WIN32)
+    return VirtualLock(data, size);
+#else
+    return mlock(data, size) == 0;
+#endif
 }
@@ -2,6 +2,31 @@
 
 #include "defines.h"
 
-void *PermanentStorageInit(U32 size);
+// Address space reserved for the permanent arena unless APOLLO_ARENA_SIZE
+// says otherwise. Pages only become resident once used, so this is a cap
+// rather than a cost.
+#define PERMANENT_STORAGE_SIZE (16ull * 1024 * 1024 * 1024)
 
-void PermanentStorageDestroy(void *permanent_storage);
+// Scratch space for a single frame. Reserved the same way, so only the peak
+// a frame actually reaches is ever resident.
+#define TRANSIENT_STORAGE_SIZE (256ull * 1024 * 1024)
+
+// Step the arena commits in, and the step with transparent huge pages
+// (APOLLO_HUGE_PAGES=1).
+#define PERMANENT_STORAGE_GRANULE (64 * 1024)
+#define PERMANENT_STORAGE_HUGE_GRANULE (2 * 1024 * 1024)
+
+typedef struct PermanentStorageConfig {
+    U64 size;
+    B8  huge_pages;
+} PermanentStorageConfig;
+
+PermanentStorageConfig PermanentStorageGetConfig();
+
+void *PermanentStorageInit(PermanentStorageConfig config);
+
+B8 PermanentStorageCommit(void *data, U64 size);
+
+void PermanentStorageDestroy(void *permanent_storage, U64 size);
+
+B8 PermanentStorageLock(void *data, U64 size);
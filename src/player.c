@@ -0,0 +1,380 @@
+#include "player.h"
+
+#include <string.h>
+
+#include "arena.h"
+#include "defines.h"
+#include "lmath.h"
+#include "mutex.h"
+#include "pcm_queue.h"
+#include "raylib.h"
+#include "resampler.h"
+#include "thread.h"
+#include "track.h"
+
+// Stream callbacks don't take user data, and there is only one player.
+static Player *processing;
+
+// Runs on the audio thread. Anything the decode thread hasn't delivered yet
+// plays as silence.
+static void
+StreamCallback(void *buffer_data, U32 n) {
+    F32 *frames = buffer_data;
+    U32  count = PcmQueueRead(&processing->queue, frames, n);
+
+    memset(frames + count * PLAYER_CHANNELS, 0,
+           (n - count) * PLAYER_CHANNELS * sizeof(F32));
+}
+
+static void
+CreateStream(Player *player, U32 sample_rate) {
+    if (IsAudioStreamReady(player->stream)) {
+        DetachAudioStreamProcessor(player->stream, player->processor);
+        UnloadAudioStream(player->stream);
+    }
+
+    player->sample_rate = sample_rate;
+    player->stream = LoadAudioStream(sample_rate, 32, PLAYER_CHANNELS);
+
+    SetAudioStreamCallback(player->stream, StreamCallback);
+    AttachAudioStreamProcessor(player->stream, player->processor);
+}
+
+static void
+ResetResamplers(Player *player, Track *track) {
+    for (U32 c = 0; c < PLAYER_CHANNELS; ++c) {
+        ResamplerInitialise(&player->resamplers[c], track->decoder.sample_rate,
+                            player->sample_rate);
+    }
+}
+
+// Drops whatever is queued and starts again from tracks[0] at offset. Called
+// with the mutex held.
+static void
+Restart(Player *player, U64 offset) {
+    PcmQueueFlush(&player->queue);
+
+    player->boundary = 0;
+    player->track_start = PcmQueueWritten(&player->queue);
+    player->track_offset = offset;
+    player->staged = 0;
+    player->feeding = 0;
+
+    ResetResamplers(player, player->tracks[0]);
+}
+
+// Converts frames to the stream rate and layout, and appends them to staging.
+// Mono is duplicated; anything past the second channel is dropped.
+static void
+Stage(Player *player, Track *track, U32 frame_count) {
+    U32 channels = track->decoder.channels;
+    U32 count = 0;
+
+    for (U32 c = 0; c < PLAYER_CHANNELS; ++c) {
+        count = ResamplerProcess(
+            &player->resamplers[c], player->scratch + MinU32(c, channels - 1),
+            channels, frame_count, player->resampled[c]);
+    }
+
+    F32 *out = player->staging + player->staged * PLAYER_CHANNELS;
+
+    for (U32 i = 0; i < count; ++i) {
+        for (U32 c = 0; c < PLAYER_CHANNELS; ++c) {
+            out[i * PLAYER_CHANNELS + c] = player->resampled[c][i];
+        }
+    }
+
+    player->staged += count;
+}
+
+// Decodes until a full block is staged or there is nothing left to play. When
+// tracks[0] runs out, decoding carries straight on into tracks[1] so there is
+// no gap between them.
+static void
+Refill(Player *player) {
+    while (player->staged < PLAYER_BLOCK) {
+        Track *track = player->tracks[player->feeding];
+        U32    capacity = ResamplerMaxInput(&player->resamplers[0],
+                                            2 * PLAYER_BLOCK - player->staged);
+        U32    count =
+            TrackRead(track, player->scratch, MinU32(capacity, PLAYER_BLOCK));
+
+        if (count > 0) {
+            Stage(player, track, count);
+            continue;
+        }
+
+        if (player->feeding == 1 || !player->loaded[1]) {
+            break;
+        }
+
+        player->feeding = 1;
+        player->boundary = PcmQueueWritten(&player->queue) + player->staged;
+
+        // Keep the filter history across the join when the rates match.
+        if (player->tracks[1]->decoder.sample_rate !=
+            track->decoder.sample_rate) {
+            ResetResamplers(player, player->tracks[1]);
+        }
+    }
+}
+
+// The mutex is held for one block at a time, so the render thread never
+// waits on more than a single refill.
+static void *
+DecodeThread(void *data) {
+    Player *player = data;
+
+    while (atomic_load(&player->running)) {
+        B8 wrote = false;
+
+        MutexLock(&player->mutex);
+
+        if (player->loaded[0] &&
+            PcmQueueFree(&player->queue) >= 2 * PLAYER_BLOCK) {
+            Refill(player);
+
+            if (player->staged > 0) {
+                PcmQueueWrite(&player->queue, player->staging, player->staged);
+                player->staged = 0;
+                wrote = true;
+            }
+        }
+
+        MutexUnlock(&player->mutex);
+
+        if (!wrote) {
+            ThreadSleep(PLAYER_POLL_INTERVAL);
+        }
+    }
+
+    return NULL;
+}
+
+void
+PlayerInitialise(Player *player, AudioCallback processor, MemoryArena *arena) {
+    memset(player, 0, sizeof(Player));
+
+    player->processor = processor;
+    player->tracks[0] = ArenaPushStruct(arena, Track);
+    player->tracks[1] = ArenaPushStruct(arena, Track);
+
+    PcmQueueReset(&player->queue, PLAYER_CHANNELS);
+    MutexCreate(&player->mutex);
+
+    processing = player;
+
+    atomic_store(&player->running, true);
+    player->thread = ThreadAlloc(arena);
+    ThreadCreate(player->thread, DecodeThread, player);
+}
+
+void
+PlayerDestroy(Player *player) {
+    atomic_store(&player->running, false);
+    ThreadJoin(player->thread);
+
+    if (IsAudioStreamReady(player->stream)) {
+        UnloadAudioStream(player->stream);
+    }
+
+    for (U32 i = 0; i < 2; ++i) {
+        if (player->loaded[i]) {
+            TrackClose(player->tracks[i]);
+        }
+    }
+
+    MutexDestroy(&player->mutex);
+}
+
+// Replaces everything with track and starts playing it. The player takes
+// ownership of the track's decoder.
+void
+PlayerLoad(Player *player, Track *track) {
+    MutexLock(&player->mutex);
+
+    for (U32 i = 0; i < 2; ++i) {
+        if (player->loaded[i]) {
+            TrackClose(player->tracks[i]);
+            player->loaded[i] = false;
+        }
+    }
+
+    memcpy(player->tracks[0], track, sizeof(Track));
+    player->loaded[0] = true;
+    player->paused = false;
+
+    // Unloading the stream stops its callback, so the queue can be reset.
+    if (!IsAudioStreamReady(player->stream) ||
+        player->sample_rate != track->decoder.sample_rate) {
+        CreateStream(player, track->decoder.sample_rate);
+        PcmQueueReset(&player->queue, PLAYER_CHANNELS);
+    }
+
+    Restart(player, 0);
+
+    MutexUnlock(&player->mutex);
+
+    PlayAudioStream(player->stream);
+}
+
+// Sets the track that follows the current one, replacing any queued before.
+void
+PlayerQueue(Player *player, Track *track) {
+    MutexLock(&player->mutex);
+
+    if (player->feeding == 1) {
+        // Already being decoded; it has to stay.
+        TrackClose(track);
+    } else {
+        if (player->loaded[1]) {
+            TrackClose(player->tracks[1]);
+        }
+
+        memcpy(player->tracks[1], track, sizeof(Track));
+        player->loaded[1] = true;
+    }
+
+    MutexUnlock(&player->mutex);
+}
+
+// Moves tracks[1] into tracks[0]. Called with the mutex held.
+static void
+Advance(Player *player) {
+    TrackClose(player->tracks[0]);
+
+    Track *track = player->tracks[0];
+    player->tracks[0] = player->tracks[1];
+    player->tracks[1] = track;
+    player->loaded[1] = false;
+}
+
+// Jumps straight to the queued track. Returns false if there is none.
+B8
+PlayerSkip(Player *player) {
+    MutexLock(&player->mutex);
+
+    B8 ret = player->loaded[1];
+
+    if (ret) {
+        if (player->feeding == 1) {
+            TrackSeek(player->tracks[1], 0);
+        }
+
+        Advance(player);
+        Restart(player, 0);
+    }
+
+    MutexUnlock(&player->mutex);
+
+    return ret;
+}
+
+// Call once per frame. Returns true when playback has moved on to the queued
+// track. Decoding happens on the decode thread; if it is mid-refill, the
+// check waits for the next frame rather than blocking this one.
+B8
+PlayerUpdate(Player *player) {
+    B8 ret = false;
+
+    if (!MutexTryLock(&player->mutex)) {
+        return false;
+    }
+
+    if (player->feeding == 1 &&
+        PcmQueueReadPosition(&player->queue) >= player->boundary) {
+        Advance(player);
+
+        player->feeding = 0;
+        player->track_start = player->boundary;
+        player->track_offset = 0;
+
+        ret = true;
+    }
+
+    MutexUnlock(&player->mutex);
+
+    return ret;
+}
+
+void
+PlayerSeek(Player *player, F32 seconds) {
+    MutexLock(&player->mutex);
+
+    if (player->loaded[0]) {
+        // The queued track may already have been partly decoded.
+        if (player->feeding == 1) {
+            TrackSeek(player->tracks[1], 0);
+        }
+
+        U64 frame =
+            MaxF32(seconds, 0.0f) * player->tracks[0]->decoder.sample_rate;
+
+        TrackSeek(player->tracks[0], frame);
+        Restart(player, frame);
+    }
+
+    MutexUnlock(&player->mutex);
+}
+
+void
+PlayerPause(Player *player) {
+    player->paused = true;
+
+    if (player->loaded[0]) {
+        PauseAudioStream(player->stream);
+    }
+}
+
+void
+PlayerResume(Player *player) {
+    player->paused = false;
+
+    if (player->loaded[0]) {
+        ResumeAudioStream(player->stream);
+    }
+}
+
+B8
+PlayerIsReady(Player *player) {
+    return player->loaded[0];
+}
+
+B8
+PlayerIsPlaying(Player *player) {
+    return player->loaded[0] && !player->paused;
+}
+
+B8
+PlayerHasNext(Player *player) {
+    return player->loaded[1];
+}
+
+F32
+PlayerTimePlayed(Player *player) {
+    if (!player->loaded[0]) {
+        return 0.0f;
+    }
+
+    U64 read = PcmQueueReadPosition(&player->queue);
+    U64 frames = read > player->track_start ? read - player->track_start : 0;
+
+    return (F32)player->track_offset /
+               player->tracks[0]->decoder.sample_rate +
+           (F32)frames / player->sample_rate;
+}
+
+F32
+PlayerTimeLength(Player *player) {
+    if (!player->loaded[0]) {
+        return 0.0f;
+    }
+
+    return (F32)player->tracks[0]->decoder.frame_count /
+           player->tracks[0]->decoder.sample_rate;
+}
+
+const char *
+PlayerPath(Player *player) {
+    return player->tracks[0]->path;
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "arena.h"
+#include "defines.h"
+#include "mutex.h"
+#include "pcm_queue.h"
+#include "raylib.h"
+#include "resampler.h"
+#include "thread.h"
+#include "track.h"
+
+#define PLAYER_CHANNELS PCM_QUEUE_MAX_CHANNELS
+
+// Frames decoded per step of the decode thread.
+#define PLAYER_BLOCK 4096
+
+// How long the decode thread sleeps once the queue is full.
+#define PLAYER_POLL_INTERVAL 0.005
+
+// Plays tracks back to back through a single float stream. The stream keeps
+// the rate of the track it was opened for; later tracks are resampled to it,
+// so moving on to the next track never reopens the device.
+//
+// A decode thread keeps queue topped up and the stream callback drains it on
+// the audio thread, so playback never depends on the render loop.
+typedef struct Player {
+    AudioStream   stream;
+    AudioCallback processor;
+    U32           sample_rate;
+    B8            paused;
+
+    Thread     *thread;
+    _Atomic I32 running;
+
+    // Guards everything below except queue, which is lock-free. Held by the
+    // decode thread while it decodes and by the render thread while it
+    // changes tracks; never by the audio thread.
+    Mutex mutex;
+
+    // tracks[0] is the one being heard, tracks[1] the one queued after it.
+    // Decoding moves on to tracks[1] before it is heard.
+    Track *tracks[2];
+    B8     loaded[2];
+    U32    feeding;
+
+    Resampler resamplers[PLAYER_CHANNELS];
+
+    PcmQueue queue;
+
+    // Queue frame at which tracks[1] becomes audible.
+    U64 boundary;
+
+    // Queue frame at which tracks[0] started, and the track frame it started
+    // from.
+    U64 track_start;
+    U64 track_offset;
+
+    U32 staged;
+    F32 staging[2 * PLAYER_BLOCK * PLAYER_CHANNELS];
+    F32 scratch[PLAYER_BLOCK * DECODER_MAX_CHANNELS];
+    F32 resampled[PLAYER_CHANNELS][2 * PLAYER_BLOCK];
+} Player;
+
+void
+PlayerInitialise(Player *player, AudioCallback processor, MemoryArena *arena);
+void
+PlayerDestroy(Player *player);
+void
+PlayerLoad(Player *player, Track *track);
+void
+PlayerQueue(Player *player, Track *track);
+B8
+PlayerSkip(Player *player);
+B8
+PlayerUpdate(Player *player);
+void
+PlayerSeek(Player *player, F32 seconds);
+void
+PlayerPause(Player *player);
+void
+PlayerResume(Player *player);
+B8
+PlayerIsReady(Player *player);
+B8
+PlayerIsPlaying(Player *player);
+B8
+PlayerHasNext(Player *player);
+F32
+PlayerTimePlayed(Player *player);
+F32
+PlayerTimeLength(Player *player);
+const char *
+PlayerPath(Player *player);
@@ -0,0 +1,92 @@
+#include "playlist.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "decoder.h"
+#include "defines.h"
+#include "lmath.h"
+#include "raylib.h"
+
+static int
+ComparePaths(const void *a, const void *b) {
+    return strcmp(*(const char **)a, *(const char **)b);
+}
+
+static U32
+AddFile(Playlist *playlist, const char *path) {
+    if (playlist->count >= PLAYLIST_CAPACITY || !DecoderSupports(path) ||
+        strlen(path) >= sizeof(playlist->paths[0])) {
+        return 0;
+    }
+
+    strcpy(playlist->paths[playlist->count++], path);
+
+    return 1;
+}
+
+void
+PlaylistClear(Playlist *playlist) {
+    playlist->count = 0;
+    playlist->index = 0;
+}
+
+// Adds a file, or every supported file in a directory in name order. Returns
+// the number of tracks added.
+U32
+PlaylistAdd(Playlist *playlist, const char *path) {
+    if (!DirectoryExists(path)) {
+        return AddFile(playlist, path);
+    }
+
+    FilePathList files = LoadDirectoryFilesEx(path, DECODER_EXTENSIONS, false);
+    U32          added = 0;
+
+    qsort(files.paths, files.count, sizeof(char *), ComparePaths);
+
+    for (U32 i = 0; i < files.count; ++i) {
+        added += AddFile(playlist, files.paths[i]);
+    }
+
+    UnloadDirectoryFiles(files);
+
+    return added;
+}
+
+void
+PlaylistRemove(Playlist *playlist, U32 index) {
+    if (index >= playlist->count) {
+        return;
+    }
+
+    memmove(playlist->paths[index], playlist->paths[index + 1],
+            (playlist->count - index - 1) * sizeof(playlist->paths[0]));
+    playlist->count--;
+
+    if (playlist->index > index) {
+        playlist->index--;
+    }
+
+    if (playlist->index >= playlist->count) {
+        playlist->index = 0;
+    }
+}
+
+const char *
+PlaylistCurrent(Playlist *playlist) {
+    if (playlist->count == 0) {
+        return NULL;
+    }
+
+    return playlist->paths[playlist->index];
+}
+
+U32
+PlaylistNextIndex(Playlist *playlist) {
+    return (playlist->index + 1) % MaxU32(playlist->count, 1);
+}
+
+void
+PlaylistAdvance(Playlist *playlist) {
+    playlist->index = PlaylistNextIndex(playlist);
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "defines.h"
+
+#define PLAYLIST_CAPACITY 512
+
+// Ordered list of track paths. Wraps around at the end, so a single track
+// repeats.
+typedef struct Playlist {
+    U32  count;
+    U32  index;
+    char paths[PLAYLIST_CAPACITY][256];
+} Playlist;
+
+void
+PlaylistClear(Playlist *playlist);
+U32
+PlaylistAdd(Playlist *playlist, const char *path);
+void
+PlaylistRemove(Playlist *playlist, U32 index);
+const char *
+PlaylistCurrent(Playlist *playlist);
+U32
+PlaylistNextIndex(Playlist *playlist);
+void
+PlaylistAdvance(Playlist *playlist);
@@ -0,0 +1,119 @@
+#include "pool.h"
+
+#include <string.h>
+
+#include "arena.h"
+#include "defines.h"
+#include "lmath.h"
+#include "mutex.h"
+#include "thread.h"
+
+static void
+RunJobs(Pool *pool) {
+    for (;;) {
+        U32 index = atomic_fetch_add(&pool->next, 1);
+
+        if (index >= pool->job_count) {
+            break;
+        }
+
+        pool->job(pool->user_data, index);
+    }
+}
+
+static void *
+WorkerThread(void *data) {
+    Pool *pool = data;
+    U32   seen = 0;
+
+    MutexLock(&pool->mutex);
+
+    for (;;) {
+        while (pool->generation == seen && !pool->quit) {
+            ConditionWait(&pool->wake, &pool->mutex);
+        }
+
+        if (pool->quit) {
+            break;
+        }
+
+        seen = pool->generation;
+
+        MutexUnlock(&pool->mutex);
+        RunJobs(pool);
+        MutexLock(&pool->mutex);
+
+        if (--pool->active == 0) {
+            ConditionSignal(&pool->done);
+        }
+    }
+
+    MutexUnlock(&pool->mutex);
+
+    return NULL;
+}
+
+// thread_count of 0 uses one thread per core, less one for the caller.
+void
+PoolInitialise(Pool *pool, U32 thread_count, MemoryArena *arena) {
+    memset(pool, 0, sizeof(Pool));
+
+    if (thread_count == 0) {
+        thread_count = ThreadCoreCount() - 1;
+    }
+
+    pool->thread_count = MinU32(thread_count, POOL_MAX_THREADS);
+
+    MutexCreate(&pool->mutex);
+    ConditionCreate(&pool->wake);
+    ConditionCreate(&pool->done);
+
+    for (U32 i = 0; i < pool->thread_count; ++i) {
+        pool->threads[i] = ThreadAlloc(arena);
+        ThreadCreate(pool->threads[i], WorkerThread, pool);
+    }
+}
+
+void
+PoolDestroy(Pool *pool) {
+    MutexLock(&pool->mutex);
+    pool->quit = true;
+    ConditionBroadcast(&pool->wake);
+    MutexUnlock(&pool->mutex);
+
+    for (U32 i = 0; i < pool->thread_count; ++i) {
+        ThreadJoin(pool->threads[i]);
+    }
+
+    ConditionDestroy(&pool->wake);
+    ConditionDestroy(&pool->done);
+    MutexDestroy(&pool->mutex);
+}
+
+// Runs job for every index below job_count and returns once all of them have
+// finished. Only one batch runs at a time per pool.
+void
+PoolRun(Pool *pool, U32 job_count, PoolJob job, void *user_data) {
+    MutexLock(&pool->mutex);
+
+    pool->job = job;
+    pool->user_data = user_data;
+    pool->job_count = job_count;
+    atomic_store(&pool->next, 0);
+
+    pool->active = pool->thread_count;
+    pool->generation++;
+    ConditionBroadcast(&pool->wake);
+
+    MutexUnlock(&pool->mutex);
+
+    RunJobs(pool);
+
+    MutexLock(&pool->mutex);
+
+    while (pool->active > 0) {
+        ConditionWait(&pool->done, &pool->mutex);
+    }
+
+    MutexUnlock(&pool->mutex);
+}
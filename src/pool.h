@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "arena.h"
+#include "defines.h"
+#include "mutex.h"
+#include "thread.h"
+
+#define POOL_MAX_THREADS 32
+
+typedef void (*PoolJob)(void *user_data, U32 index);
+
+// Fixed set of worker threads that run batches of independent jobs. The
+// caller works through the batch alongside them, so a pool with no threads
+// still runs everything, just serially.
+typedef struct Pool {
+    Thread *threads[POOL_MAX_THREADS];
+    U32     thread_count;
+
+    Mutex     mutex;
+    Condition wake;
+    Condition done;
+
+    U32 generation;
+    U32 active;
+    B8  quit;
+
+    PoolJob     job;
+    void       *user_data;
+    U32         job_count;
+    _Atomic U32 next;
+} Pool;
+
+void
+PoolInitialise(Pool *pool, U32 thread_count, MemoryArena *arena);
+void
+PoolDestroy(Pool *pool);
+void
+PoolRun(Pool *pool, U32 job_count, PoolJob job, void *user_data);
@@ -1,132 +1,156 @@
 #include "procedures.h"
-#include "arena.h"
+
 #include <stdbool.h>
-#include <stdlib.h>
+#include <stdio.h>
 #include <string.h>
 
-static U64
-ProcedureHash(const void *item, U64 seed0, U64 seed1) {
-    Procedure *proc = (Procedure *)item;
+#include "lmath.h"
 
-    return hashmap_sip(proc->name, strlen(proc->name), seed0, seed1);
-}
+// Rebuilds the render list from scratch. Only happens when procedures are
+// added or toggled, never per frame.
+static void
+Compile(Procedures *procs) {
+    procs->render_count = 0;
 
-static I32
-ProcedureCompare(const void *a, const void *b, void *udata) {
-    (void)(udata);
+    for (U32 i = 0; i < procs->count; ++i) {
+        Procedure *proc = &procs->items[i];
 
-    Procedure *pa = (Procedure *)a;
-    Procedure *pb = (Procedure *)b;
-    return strcmp(pa->name, pb->name);
+        if (proc->render && proc->active) {
+            procs->render[procs->render_count] = proc->callback;
+            procs->render_data[procs->render_count] = proc->user_data;
+            procs->render_count++;
+        }
+    }
 }
 
-static void
-ProcedureFree(void *item) {
-    Procedure *proc = (Procedure *)item;
+void
+ProceduresInitialise(Procedures *procs) {
+    memset(procs, 0, sizeof(Procedures));
+}
 
-    if (proc->user_data) {
-        free(proc->user_data);
+static ProcedureHandle
+Find(Procedures *procs, const char *name) {
+    for (U32 i = 0; i < procs->count; ++i) {
+        if (strncmp(procs->items[i].name, name, PROCEDURE_NAME_SIZE - 1) ==
+            0) {
+            return i;
+        }
     }
-}
 
-HM_Hashmap *
-ProcedureCreate() {
-    return hashmap_new(sizeof(Procedure), 0, 0, 0, ProcedureHash,
-                       ProcedureCompare, ProcedureFree, NULL);
+    return PROCEDURE_NONE;
 }
 
-Procedure *
-ProcedureAdd_(HM_Hashmap       *procs,
+/**
+ * @brief Adds a procedure, or replaces the one already added under name while
+ * keeping its place.
+ *
+ * @param procs The procedures.
+ * @param name The name shown in the UI.
+ * @param user_data Copied in and passed to callback.
+ * @param user_data_size At most PROCEDURE_USER_DATA_SIZE.
+ * @param callback The procedure.
+ * @param release Called with the user data once a later add replaces it. May
+ * be NULL.
+ * @param render Whether ProceduresRender runs it every frame.
+ * @return ProcedureHandle The procedure, or PROCEDURE_NONE if there is no room.
+ */
+ProcedureHandle
+ProcedureAdd_(Procedures       *procs,
               const char       *name,
               void             *user_data,
               U32               user_data_size,
-              ProcedureCallback proc,
-              MemoryArena      *arena) {
-    Procedure *procedure = ArenaPushStruct(arena, Procedure);
-    procedure->callback = proc;
+              ProcedureCallback callback,
+              ProcedureRelease  release,
+              B8                render) {
+    ProcedureHandle handle = Find(procs, name);
+
+    if (handle == PROCEDURE_NONE) {
+        if (procs->count == PROCEDURE_CAPACITY) {
+            printf("WARNING: no room for procedure %s\n", name);
+            return PROCEDURE_NONE;
+        }
+
+        handle = procs->count++;
+    }
+
+    Procedure *proc = &procs->items[handle];
+
+    if (proc->release) {
+        proc->release(proc->user_data);
+    }
 
-    procedure->name = ArenaPushString(arena, name);
+    memset(proc, 0, sizeof(Procedure));
+    snprintf(proc->name, PROCEDURE_NAME_SIZE, "%s", name);
 
-    procedure->active = true;
+    proc->callback = callback;
+    proc->release = release;
+    proc->active = true;
+    proc->render = render;
 
     if (user_data) {
-        procedure->user_data = malloc(user_data_size);
-        memcpy(procedure->user_data, user_data, user_data_size);
+        memcpy(proc->user_data, user_data,
+               MinU32(user_data_size, PROCEDURE_USER_DATA_SIZE));
     }
 
-    hashmap_set(procs, procedure);
+    Compile(procs);
 
-    return procedure;
+    return handle;
 }
 
-_Procedure
-_ProcedureAdd(HM_Hashmap       *procs,
-              const char       *name,
-              void             *user_data,
-              ProcedureCallback proc,
-              MemoryArena      *arena) {
-    ProcedureAdd(procs, name, user_data, proc, arena);
-
-    return ProcedureGeneratePtr(procs, name);
+B8
+ProcedureValid(Procedures *procs, ProcedureHandle handle) {
+    return handle < procs->count;
 }
 
-void
-ProcedureCall(HM_Hashmap *procs, const char *name) {
-    Procedure *proc =
-        (Procedure *)hashmap_get(procs, &(Procedure){.name = (char *)name});
+U32
+ProcedureCount(Procedures *procs) {
+    return procs->count;
+}
 
-    if (proc) {
-        if (proc->active) {
-            proc->callback(proc->user_data);
-        }
-    }
+const char *
+ProcedureName(Procedures *procs, ProcedureHandle handle) {
+    return procs->items[handle].name;
 }
 
-void
-_ProcedureCall(_Procedure proc) {
-    ProcedureCall(proc.procedures, proc.name);
+B8
+ProcedureActive(Procedures *procs, ProcedureHandle handle) {
+    return procs->items[handle].active;
 }
 
 void
-ProcedureCallAll(HM_Hashmap *procs) {
-    U32        iter = 0;
-    Procedure *proc;
-    while (ProcedureIter(procs, &iter, &proc)) {
-        if (proc->active) {
-            proc->callback(proc->user_data);
-        }
+ProcedureSetActive(Procedures *procs, ProcedureHandle handle, B8 active) {
+    if (!ProcedureValid(procs, handle)) {
+        return;
     }
-}
 
-void
-ProcedureToggle(HM_Hashmap *procs, const char *name) {
-    Procedure *proc =
-        (Procedure *)hashmap_get(procs, &(Procedure){.name = (char *)name});
+    procs->items[handle].active = active;
 
-    if (proc) {
-        proc->active = !proc->active;
-    }
+    Compile(procs);
 }
 
-B8
-ProcedureIter(HM_Hashmap *procs, U32 *iter, Procedure **procedure) {
-    return hashmap_iter(procs, iter, (void **)procedure);
+void
+ProcedureToggle(Procedures *procs, ProcedureHandle handle) {
+    if (ProcedureValid(procs, handle)) {
+        ProcedureSetActive(procs, handle, !procs->items[handle].active);
+    }
 }
 
-typedef struct StateWrapperData {
-    void (*callback)(void *user_data);
-    void *user_data;
-} StateWrapperData;
-
 void
-ProcedureStateWrapper(void *user_data) {}
-
-_Procedure
-ProcedureGeneratePtr(HM_Hashmap *procs, const char *name) {
-    _Procedure proc = (_Procedure){.procedures = procs};
+ProcedureCall(Procedures *procs, ProcedureHandle handle) {
+    if (!ProcedureValid(procs, handle)) {
+        return;
+    }
 
-    memcpy(proc.name, name, strlen(name) + 1);
+    Procedure *proc = &procs->items[handle];
 
-    return proc;
+    if (proc->active) {
+        proc->callback(proc->user_data);
+    }
 }
 
+void
+ProceduresRender(Procedures *procs) {
+    for (U32 i = 0; i < procs->render_count; ++i) {
+        procs->render[i](procs->render_data[i]);
+    }
+}
@@ -1,59 +1,87 @@
 #pragma once
 
-#include "arena.h"
 #include "defines.h"
-#include "hashmap.h"
+
+#define PROCEDURE_CAPACITY 64
+#define PROCEDURE_NAME_SIZE 64
+
+// Largest user data a procedure can carry; it is copied in on add.
+#define PROCEDURE_USER_DATA_SIZE 16
 
 typedef void (*ProcedureCallback)(void *data);
 
+// Called with a procedure's user data before it is replaced by a procedure
+// added under the same name.
+typedef void (*ProcedureRelease)(void *data);
+
+// Index into Procedures, in the order procedures were added.
+typedef U32 ProcedureHandle;
+
+#define PROCEDURE_NONE ((ProcedureHandle)-1)
+
 typedef struct Procedure {
-    char             *name;
+    char              name[PROCEDURE_NAME_SIZE];
     ProcedureCallback callback;
+    ProcedureRelease  release;
     B8                active;
-    void             *user_data;
+
+    // Run every frame by ProceduresRender rather than only when called.
+    B8 render;
+
+    // Callbacks read pointers and handles straight out of this.
+    _Alignas(16) U8 user_data[PROCEDURE_USER_DATA_SIZE];
 } Procedure;
 
-typedef struct _Procedure {
-    char        name[512];
-    HM_Hashmap *procedures;
-} _Procedure;
+// Procedures are kept in the order they were added. The active render
+// procedures are compiled into a flat list whenever one is added or toggled,
+// so drawing them each frame is a plain loop.
+typedef struct Procedures {
+    Procedure items[PROCEDURE_CAPACITY];
+    U32       count;
+
+    ProcedureCallback render[PROCEDURE_CAPACITY];
+    void             *render_data[PROCEDURE_CAPACITY];
+    U32               render_count;
+} Procedures;
+
+#define ProcedureAdd(procs, name, user_data, callback)                         \
+    ProcedureAdd_((procs), (name), (void *)(user_data), sizeof(*(user_data)),  \
+                  (callback), NULL, false)
 
-HM_Hashmap *
-ProcedureCreate();
+#define ProcedureAddWithRelease(procs, name, user_data, callback, release)     \
+    ProcedureAdd_((procs), (name), (void *)(user_data), sizeof(*(user_data)),  \
+                  (callback), (release), false)
 
-#define ProcedureAdd(procedures, name, user_data, callback, arena)             \
-    ProcedureAdd_((procedures), (name), (void *)(user_data),                   \
-                  sizeof(*(user_data)), (callback), (arena))
+#define ProcedureAddRender(procs, name, user_data, callback)                   \
+    ProcedureAdd_((procs), (name), (void *)(user_data), sizeof(*(user_data)),  \
+                  (callback), NULL, true)
+
+void
+ProceduresInitialise(Procedures *procs);
 
-Procedure *
-ProcedureAdd_(HM_Hashmap       *procedures,
+ProcedureHandle
+ProcedureAdd_(Procedures       *procs,
               const char       *name,
               void             *user_data,
               U32               user_data_size,
               ProcedureCallback callback,
-              MemoryArena      *arena);
-
-_Procedure
-_ProcedureAdd(HM_Hashmap       *procs,
-              const char       *name,
-              void             *user_data,
-              ProcedureCallback proc,
-              MemoryArena      *arena);
+              ProcedureRelease  release,
+              B8                render);
 
+B8
+ProcedureValid(Procedures *procs, ProcedureHandle handle);
+U32
+ProcedureCount(Procedures *procs);
+const char *
+ProcedureName(Procedures *procs, ProcedureHandle handle);
+B8
+ProcedureActive(Procedures *procs, ProcedureHandle handle);
 void
-ProcedureCall(HM_Hashmap *procedures, const char *name);
-
+ProcedureSetActive(Procedures *procs, ProcedureHandle handle, B8 active);
 void
-_ProcedureCall(_Procedure proc);
+ProcedureToggle(Procedures *procs, ProcedureHandle handle);
 
 void
-ProcedureCallAll(HM_Hashmap *procedures);
-
-B8
-ProcedureIter(HM_Hashmap *procedures, U32 *iter, Procedure **procedure);
-
+ProcedureCall(Procedures *procs, ProcedureHandle handle);
 void
-ProcedureToggle(HM_Hashmap *procs, const char *name);
-
-_Procedure
-ProcedureGeneratePtr(HM_Hashmap *procs, const char *name);
+ProceduresRender(Procedures *procs);
@@ -0,0 +1,117 @@
+#include "realtime.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "defines.h"
+#include "permanent_storage.h"
+#include "thread.h"
+
+void
+RealtimeInitialise(Realtime *realtime, RealtimeConfig config) {
+    memset(realtime, 0, sizeof(Realtime));
+
+    realtime->config = config;
+}
+
+B8
+RealtimeEnabled(Realtime *realtime) {
+    return realtime->config.priority > 0;
+}
+
+// Called at the top of every audio callback. Only the first call on each
+// thread does anything.
+void
+RealtimePromoteAudio(Realtime *realtime) {
+    static _Thread_local B8 promoted;
+
+    if (promoted || !RealtimeEnabled(realtime)) {
+        return;
+    }
+
+    promoted = true;
+
+    if (ThreadSetRealtime(NULL, realtime->config.priority, false)) {
+        atomic_fetch_add(&realtime->audio_scheduled, 1);
+    }
+
+    if (realtime->config.audio_core >= 0 &&
+        ThreadSetAffinity(NULL, realtime->config.audio_core)) {
+        atomic_fetch_add(&realtime->audio_pinned, 1);
+    }
+
+    atomic_fetch_add(&realtime->audio_threads, 1);
+}
+
+// Analysis threads share a priority, so they round-robin among themselves.
+void
+RealtimePromoteAnalysis(Realtime *realtime, Thread *thread) {
+    if (!RealtimeEnabled(realtime)) {
+        return;
+    }
+
+    if (ThreadSetRealtime(thread, realtime->config.priority - 1, true)) {
+        realtime->analysis_scheduled++;
+    }
+
+    if (realtime->config.analysis_core >= 0 &&
+        ThreadSetAffinity(thread, realtime->config.analysis_core +
+                                      realtime->analysis_threads)) {
+        realtime->analysis_pinned++;
+    }
+
+    realtime->analysis_threads++;
+}
+
+void
+RealtimeLock(Realtime *realtime, void *data, U64 size) {
+    if (!RealtimeEnabled(realtime)) {
+        return;
+    }
+
+    realtime->lock_requested += size;
+
+    if (PermanentStorageLock(data, size)) {
+        realtime->locked += size;
+    }
+}
+
+void
+RealtimeReport(Realtime *realtime) {
+    if (!RealtimeEnabled(realtime)) {
+        return;
+    }
+
+    printf("Realtime: %u/%u analysis threads scheduled",
+           realtime->analysis_scheduled, realtime->analysis_threads);
+
+    if (realtime->config.analysis_core >= 0) {
+        printf(", %u/%u pinned", realtime->analysis_pinned,
+               realtime->analysis_threads);
+    }
+
+    printf(", %.1f/%.1f MB locked\n", realtime->locked / (1024.0 * 1024.0),
+           realtime->lock_requested / (1024.0 * 1024.0));
+}
+
+// Call once per frame. Reports audio threads as they first run.
+void
+RealtimeUpdate(Realtime *realtime) {
+    U32 threads = atomic_load(&realtime->audio_threads);
+
+    if (threads == realtime->audio_reported) {
+        return;
+    }
+
+    realtime->audio_reported = threads;
+
+    printf("Realtime: %u/%u audio threads scheduled",
+           atomic_load(&realtime->audio_scheduled), threads);
+
+    if (realtime->config.audio_core >= 0) {
+        printf(", %u/%u pinned", atomic_load(&realtime->audio_pinned),
+               threads);
+    }
+
+    printf("\n");
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "defines.h"
+#include "thread.h"
+
+typedef struct RealtimeConfig {
+    // Priority for audio threads; analysis threads get one less. 0 leaves
+    // realtime mode off.
+    U32 priority;
+
+    // Cores to pin to, or -1 to leave threads unpinned. Analysis threads take
+    // consecutive cores from analysis_core.
+    I32 audio_core;
+    I32 analysis_core;
+} RealtimeConfig;
+
+// Optional realtime mode for show machines: audio and analysis threads are
+// given realtime priorities and pinned to their own cores, and the buffers
+// they touch every period are locked in memory. Every step can fail without
+// privileges; what did take effect is reported instead.
+typedef struct Realtime {
+    RealtimeConfig config;
+
+    // Audio threads belong to the audio libraries, so they promote themselves
+    // from their callbacks and these are only known later.
+    _Atomic U32 audio_threads;
+    _Atomic U32 audio_scheduled;
+    _Atomic U32 audio_pinned;
+    U32         audio_reported;
+
+    U32 analysis_threads;
+    U32 analysis_scheduled;
+    U32 analysis_pinned;
+
+    U64 lock_requested;
+    U64 locked;
+} Realtime;
+
+void
+RealtimeInitialise(Realtime *realtime, RealtimeConfig config);
+B8
+RealtimeEnabled(Realtime *realtime);
+void
+RealtimePromoteAudio(Realtime *realtime);
+void
+RealtimePromoteAnalysis(Realtime *realtime, Thread *thread);
+void
+RealtimeLock(Realtime *realtime, void *data, U64 size);
+void
+RealtimeReport(Realtime *realtime);
+void
+RealtimeUpdate(Realtime *realtime);
@@ -1,9 +1,11 @@
 #include "renderer.h"
 
 #include <assert.h>
+#include <math.h>
 #include <raylib.h>
 #include <rlgl.h>
 
+#include "arena.h"
 #include "defines.h"
 #include "ffmpeg.h"
 #include "handmademath.h"
@@ -22,7 +24,7 @@ DrawFrequencyPolygon(Texture2D tex,
                      F32       bottom);
 
 void
-RendererInitialise(RendererData *renderer) {
+RendererInitialise(RendererData *renderer, MemoryArena *transient) {
     renderer->shaders[Shaders_CIRCLE_LINES] =
         LoadShader(0, "assets/shaders/circle_lines.fs");
     renderer->shaders[Shaders_LR_GRADIENT] =
@@ -32,6 +34,7 @@ RendererInitialise(RendererData *renderer) {
 
     renderer->default_color_func = DefaultColorFunc;
     renderer->screen = LoadRenderTexture(1280, 720);
+    renderer->transient = transient;
 }
 
 void
@@ -61,12 +64,19 @@ RendererBeginRecording(RendererData *renderer) {
     BeginTextureMode(renderer->screen);
 }
 
+// Sends the frame to ffmpeg copies times; 0 drops it without reading it back.
 void
-RendererEndRecording(RendererData *renderer, I32 ffmpeg) {
+RendererEndRecording(RendererData *renderer, I32 ffmpeg, U32 copies) {
     EndTextureMode();
 
+    if (copies == 0) {
+        return;
+    }
+
     Image image = LoadImageFromTexture(renderer->screen.texture);
-    { FFMPEGWrite(ffmpeg, image.data, renderer->render_size); }
+    for (U32 i = 0; i < copies; ++i) {
+        FFMPEGWrite(ffmpeg, image.data, renderer->render_size);
+    }
     UnloadImage(image);
 }
 
@@ -112,13 +122,17 @@ RendererDrawFrequencies(RendererData *renderer,
                         color_func_t *color_func) {
     F32 cell_width = (F32)renderer->render_size.Width / ((F32)frequency_count);
 
-    U32      vertex_count = frequency_count;
-    HMM_Vec2 vertices[vertex_count];
+    ArenaTemp scratch = ArenaBeginTemp(renderer->transient);
+
+    U32       vertex_count = frequency_count;
+    HMM_Vec2 *vertices =
+        ArenaPushArray(renderer->transient, vertex_count, HMM_Vec2);
 
-    Color colors[vertex_count];
+    Color *colors = ArenaPushArray(renderer->transient, vertex_count, Color);
 
-    U32      index_count = vertex_count;
-    HMM_Vec2 indices[index_count];
+    U32       index_count = vertex_count;
+    HMM_Vec2 *indices =
+        ArenaPushArray(renderer->transient, index_count, HMM_Vec2);
 
     for (U32 i = 0; i < vertex_count; ++i) {
         F32 t = frequencies[i];
@@ -153,6 +167,8 @@ RendererDrawFrequencies(RendererData *renderer,
         RendererDrawLinedPoly(renderer, vertices, vertex_count, indices,
                               index_count, WHITE);
     }
+
+    ArenaEndTemp(scratch);
 }
 
 void
@@ -181,6 +197,169 @@ RendererDrawLinedPoly(RendererData *renderer,
     rlEnd();
 }
 
+// Keeps each rlBegin/rlEnd well inside rlgl's vertex batch. Long strips are
+// drawn in pieces, flushing the batch in between if it fills up.
+static void
+BeginBatch(I32 mode, U32 vertex_count, Color color) {
+    rlCheckRenderBatchLimit(vertex_count);
+    rlBegin(mode);
+    rlColor4ub(color.r, color.g, color.b, color.a);
+}
+
+// points holds x, y pairs; each two points make a separate segment.
+void
+RendererDrawLines(RendererData *renderer,
+                  const F32    *points,
+                  U32           point_count,
+                  Color         color) {
+    (void)renderer;
+
+    point_count &= ~1u;
+
+    for (U32 start = 0; start < point_count; start += RENDERER_BATCH_VERTICES) {
+        U32 end = MinU32(start + RENDERER_BATCH_VERTICES, point_count);
+
+        BeginBatch(RL_LINES, end - start, color);
+        for (U32 i = start; i < end; ++i) {
+            rlVertex2f(points[2 * i], points[2 * i + 1]);
+        }
+        rlEnd();
+    }
+}
+
+// points holds x, y pairs joined one after the other. texcoords, if given,
+// holds a u, v pair per point for shaders to read.
+void
+RendererDrawPolyline(RendererData *renderer,
+                     const F32    *points,
+                     const F32    *texcoords,
+                     U32           point_count,
+                     Color         color) {
+    (void)renderer;
+
+    if (point_count < 2) {
+        return;
+    }
+
+    U32 segment_count = point_count - 1;
+    U32 batch = RENDERER_BATCH_VERTICES / 2;
+
+    for (U32 start = 0; start < segment_count; start += batch) {
+        U32 end = MinU32(start + batch, segment_count);
+
+        BeginBatch(RL_LINES, 2 * (end - start), color);
+        for (U32 i = start; i < end; ++i) {
+            for (U32 j = i; j <= i + 1; ++j) {
+                if (texcoords) {
+                    rlTexCoord2f(texcoords[2 * j], texcoords[2 * j + 1]);
+                }
+                rlVertex2f(points[2 * j], points[2 * j + 1]);
+            }
+        }
+        rlEnd();
+    }
+}
+
+// Fills the convex polygon through points, in either winding.
+void
+RendererDrawPolygon(RendererData *renderer,
+                    const F32    *points,
+                    U32           point_count,
+                    Color         color) {
+    (void)renderer;
+
+    if (point_count < 3) {
+        return;
+    }
+
+    // rlgl culls triangles wound the other way, so follow the polygon's own
+    // winding.
+    F32 area = 0.0f;
+    for (U32 i = 0; i < point_count; ++i) {
+        U32 j = (i + 1) % point_count;
+        area += points[2 * i] * points[2 * j + 1] -
+                points[2 * j] * points[2 * i + 1];
+    }
+
+    I32 a = area > 0.0f ? 1 : 0;
+    I32 b = 1 - a;
+
+    U32 triangle_count = point_count - 2;
+    U32 batch = RENDERER_BATCH_VERTICES / 3;
+
+    for (U32 start = 0; start < triangle_count; start += batch) {
+        U32 end = MinU32(start + batch, triangle_count);
+
+        BeginBatch(RL_TRIANGLES, 3 * (end - start), color);
+        for (U32 i = start + 1; i <= end; ++i) {
+            rlVertex2f(points[0], points[1]);
+            rlVertex2f(points[2 * (i + a)], points[2 * (i + a) + 1]);
+            rlVertex2f(points[2 * (i + b)], points[2 * (i + b) + 1]);
+        }
+        rlEnd();
+    }
+}
+
+// rects holds x, y, width, height for each rectangle.
+void
+RendererDrawRects(RendererData *renderer,
+                  const F32    *rects,
+                  U32           rect_count,
+                  Color         color) {
+    (void)renderer;
+
+    U32 batch = RENDERER_BATCH_VERTICES / 6;
+
+    for (U32 start = 0; start < rect_count; start += batch) {
+        U32 end = MinU32(start + batch, rect_count);
+
+        BeginBatch(RL_TRIANGLES, 6 * (end - start), color);
+        for (U32 i = start; i < end; ++i) {
+            const F32 *r = rects + 4 * i;
+
+            rlVertex2f(r[0], r[1]);
+            rlVertex2f(r[0], r[1] + r[3]);
+            rlVertex2f(r[0] + r[2], r[1]);
+
+            rlVertex2f(r[0] + r[2], r[1]);
+            rlVertex2f(r[0], r[1] + r[3]);
+            rlVertex2f(r[0] + r[2], r[1] + r[3]);
+        }
+        rlEnd();
+    }
+}
+
+// circles holds x, y, radius for each circle.
+void
+RendererDrawCircles(RendererData *renderer,
+                    const F32    *circles,
+                    U32           circle_count,
+                    Color         color) {
+    (void)renderer;
+
+    F32 step = 2 * PI / RENDERER_CIRCLE_SEGMENTS;
+    U32 batch = RENDERER_BATCH_VERTICES / (3 * RENDERER_CIRCLE_SEGMENTS);
+
+    for (U32 start = 0; start < circle_count; start += batch) {
+        U32 end = MinU32(start + batch, circle_count);
+
+        BeginBatch(RL_TRIANGLES, 3 * RENDERER_CIRCLE_SEGMENTS * (end - start),
+                   color);
+        for (U32 i = start; i < end; ++i) {
+            const F32 *c = circles + 3 * i;
+
+            for (U32 s = 0; s < RENDERER_CIRCLE_SEGMENTS; ++s) {
+                rlVertex2f(c[0], c[1]);
+                rlVertex2f(c[0] + cosf(step * (s + 1)) * c[2],
+                           c[1] + sinf(step * (s + 1)) * c[2]);
+                rlVertex2f(c[0] + cosf(step * s) * c[2],
+                           c[1] + sinf(step * s) * c[2]);
+            }
+        }
+        rlEnd();
+    }
+}
+
 void
 RendererDrawCircleFrequencies(RendererData *renderer,
                               U32           frequency_count,
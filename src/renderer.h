@@ -1,9 +1,15 @@
 #pragma once
 
+#include "arena.h"
 #include "defines.h"
 #include "handmademath.h"
 #include "raylib.h"
 
+// Most vertices emitted between one rlBegin and rlEnd by the batch draws.
+#define RENDERER_BATCH_VERTICES 4096
+
+#define RENDERER_CIRCLE_SEGMENTS 32
+
 typedef Color(color_func_t)(F32 t);
 
 typedef enum Textures { Textures_DEFAULT = 0, TEXTURES_MAX } Textures;
@@ -23,9 +29,12 @@ typedef struct RendererData {
     HMM_Vec2 render_size;
 
     color_func_t *default_color_func;
+
+    // Per-frame scratch memory, owned by the state.
+    MemoryArena *transient;
 } RendererData;
 
-void RendererInitialise(RendererData *renderer);
+void RendererInitialise(RendererData *renderer, MemoryArena *transient);
 void RendererDestroy(RendererData *renderer);
 
 void RendererSetRenderSize(RendererData *renderer, HMM_Vec2 render_size);
@@ -52,10 +61,33 @@ void RendererDrawTextCenter(Font        font,
                             Color       color);
 
 void RendererBeginRecording(RendererData *renderer);
-void RendererEndRecording(RendererData *renderer, I32 ffmpeg);
+void RendererEndRecording(RendererData *renderer, I32 ffmpeg, U32 copies);
 void RendererDrawLinedPoly(RendererData *renderer,
                            HMM_Vec2     *vertices,
                            U32           vertex_count,
                            HMM_Vec2     *indices,
                            U32           index_count,
                            Color         color);
+
+// Batch draws over flat arrays of floats, one colour for the whole batch.
+void RendererDrawLines(RendererData *renderer,
+                       const F32    *points,
+                       U32           point_count,
+                       Color         color);
+void RendererDrawPolyline(RendererData *renderer,
+                          const F32    *points,
+                          const F32    *texcoords,
+                          U32           point_count,
+                          Color         color);
+void RendererDrawPolygon(RendererData *renderer,
+                         const F32    *points,
+                         U32           point_count,
+                         Color         color);
+void RendererDrawRects(RendererData *renderer,
+                       const F32    *rects,
+                       U32           rect_count,
+                       Color         color);
+void RendererDrawCircles(RendererData *renderer,
+                         const F32    *circles,
+                         U32           circle_count,
+                         Color         color);
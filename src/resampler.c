@@ -0,0 +1,183 @@
+#include "resampler.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "defines.h"
+#include "lmath.h"
+
+#if defined(__SSE__) || defined(_M_X64)
+#include <xmmintrin.h>
+#define RESAMPLER_SSE
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#define RESAMPLER_NEON
+#endif
+
+// Fraction of the output Nyquist frequency that is kept. Leaves room for the
+// transition band of a 32 tap filter.
+#define RESAMPLER_CUTOFF 0.9f
+
+static U32
+Gcd(U32 a, U32 b) {
+    while (b) {
+        U32 t = a % b;
+        a = b;
+        b = t;
+    }
+
+    return a;
+}
+
+static F64
+Sinc(F64 x) {
+    if (fabs(x) < 1e-9) {
+        return 1.0;
+    }
+
+    return sin(PI * x) / (PI * x);
+}
+
+// Blackman window over x in [-1, 1].
+static F64
+Window(F64 x) {
+    if (x <= -1.0 || x >= 1.0) {
+        return 0.0;
+    }
+
+    return 0.42 + 0.5 * cos(PI * x) + 0.08 * cos(2 * PI * x);
+}
+
+static inline F32
+Dot(const F32 *a, const F32 *b) {
+#if defined(RESAMPLER_SSE)
+    __m128 acc = _mm_setzero_ps();
+    for (U32 i = 0; i < RESAMPLER_TAPS; i += 4) {
+        acc = _mm_add_ps(acc,
+                         _mm_mul_ps(_mm_loadu_ps(a + i), _mm_loadu_ps(b + i)));
+    }
+
+    acc = _mm_add_ps(acc, _mm_movehl_ps(acc, acc));
+    acc = _mm_add_ss(acc, _mm_shuffle_ps(acc, acc, 1));
+
+    return _mm_cvtss_f32(acc);
+#elif defined(RESAMPLER_NEON)
+    float32x4_t acc = vdupq_n_f32(0.0f);
+    for (U32 i = 0; i < RESAMPLER_TAPS; i += 4) {
+        acc = vmlaq_f32(acc, vld1q_f32(a + i), vld1q_f32(b + i));
+    }
+
+    float32x2_t sum = vadd_f32(vget_low_f32(acc), vget_high_f32(acc));
+    return vget_lane_f32(vpadd_f32(sum, sum), 0);
+#else
+    F32 acc = 0.0f;
+    for (U32 i = 0; i < RESAMPLER_TAPS; ++i) {
+        acc += a[i] * b[i];
+    }
+
+    return acc;
+#endif
+}
+
+void
+ResamplerInitialise(Resampler *resampler, U32 in_rate, U32 out_rate) {
+    U32 gcd = Gcd(in_rate, out_rate);
+
+    resampler->in_rate = in_rate;
+    resampler->out_rate = out_rate;
+    resampler->up = out_rate / gcd;
+    resampler->down = in_rate / gcd;
+    resampler->passthrough = in_rate == out_rate;
+    resampler->phase_count = MinU32(resampler->up, RESAMPLER_MAX_PHASES);
+
+    // Normalised cutoff in cycles per input sample.
+    F64 cutoff =
+        0.5 * RESAMPLER_CUTOFF * MinF32(1.0f, (F32)out_rate / (F32)in_rate);
+    F64 half = RESAMPLER_TAPS / 2;
+
+    // Branch p interpolates at p / phase_count of an input sample past the
+    // centre of the history. Coefficients are stored oldest sample first to
+    // match the history layout.
+    for (U32 p = 0; p < resampler->phase_count; ++p) {
+        F64 frac = (F64)p / resampler->phase_count;
+        F64 sum = 0.0;
+
+        for (U32 i = 0; i < RESAMPLER_TAPS; ++i) {
+            F64 u = (RESAMPLER_TAPS - 1 - i) - half + frac;
+            F64 c = 2 * cutoff * Sinc(2 * cutoff * u) * Window(u / half);
+
+            resampler->coefficients[p][i] = c;
+            sum += c;
+        }
+
+        // Unity gain at DC for every branch.
+        for (U32 i = 0; i < RESAMPLER_TAPS; ++i) {
+            resampler->coefficients[p][i] /= sum;
+        }
+    }
+
+    ResamplerReset(resampler);
+}
+
+void
+ResamplerReset(Resampler *resampler) {
+    resampler->phase = 0;
+    resampler->cursor = 0;
+
+    memset(resampler->history, 0, sizeof(resampler->history));
+}
+
+// Largest input count guaranteed to produce at most out_capacity samples.
+U32
+ResamplerMaxInput(Resampler *resampler, U32 out_capacity) {
+    if (resampler->passthrough) {
+        return out_capacity;
+    }
+
+    U64 count = (U64)(out_capacity - 1) * resampler->down / resampler->up;
+
+    return MaxU32(count, 1);
+}
+
+U32
+ResamplerProcess(Resampler *resampler,
+                 const F32 *in,
+                 U32        in_stride,
+                 U32        in_count,
+                 F32       *out) {
+    if (resampler->passthrough) {
+        for (U32 i = 0; i < in_count; ++i) {
+            out[i] = in[i * in_stride];
+        }
+
+        return in_count;
+    }
+
+    U32 out_count = 0;
+
+    for (U32 i = 0; i < in_count; ++i) {
+        F32 sample = in[i * in_stride];
+
+        resampler->history[resampler->cursor] = sample;
+        resampler->history[resampler->cursor + RESAMPLER_TAPS] = sample;
+        resampler->cursor = (resampler->cursor + 1) % RESAMPLER_TAPS;
+
+        const F32 *window = resampler->history + resampler->cursor;
+
+        while (resampler->phase < resampler->up) {
+            U32 p = resampler->phase;
+
+            if (resampler->phase_count != resampler->up) {
+                p = (U64)p * resampler->phase_count / resampler->up;
+            }
+
+            out[out_count++] = Dot(window, resampler->coefficients[p]);
+
+            resampler->phase += resampler->down;
+        }
+
+        resampler->phase -= resampler->up;
+    }
+
+    return out_count;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "defines.h"
+
+// Taps per polyphase branch. Must be a multiple of 4 for the SIMD dot product.
+#define RESAMPLER_TAPS 32
+#define RESAMPLER_MAX_PHASES 256
+
+// Largest block ResamplerProcess is expected to write in one call. Callers
+// chunk their input with ResamplerMaxInput so that a stack buffer of this size
+// is always enough.
+#define RESAMPLER_BLOCK 512
+
+// Streaming mono polyphase resampler. The whole filter bank and history live
+// inside the struct, so processing never allocates. Latency is fixed at
+// RESAMPLER_TAPS / 2 input samples.
+typedef struct Resampler {
+    U32 in_rate;
+    U32 out_rate;
+
+    // Conversion ratio up/down, reduced by their gcd. phase counts in units of
+    // 1/up input samples.
+    U32 up;
+    U32 down;
+    U32 phase;
+    U32 phase_count;
+
+    B8 passthrough;
+
+    // Every input is written twice, TAPS apart, so the newest TAPS samples are
+    // always contiguous at history + cursor.
+    U32 cursor;
+    F32 history[2 * RESAMPLER_TAPS];
+
+    F32 coefficients[RESAMPLER_MAX_PHASES][RESAMPLER_TAPS];
+} Resampler;
+
+void
+ResamplerInitialise(Resampler *resampler, U32 in_rate, U32 out_rate);
+void
+ResamplerReset(Resampler *resampler);
+U32
+ResamplerMaxInput(Resampler *resampler, U32 out_capacity);
+U32
+ResamplerProcess(Resampler *resampler,
+                 const F32 *in,
+                 U32        in_stride,
+                 U32        in_count,
+                 F32       *out);
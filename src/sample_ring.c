@@ -0,0 +1,116 @@
+#include "sample_ring.h"
+
+#include <string.h>
+
+#include "defines.h"
+#include "lmath.h"
+
+void
+SampleRingReset(SampleRing *ring, U32 rate) {
+    ring->rate = rate;
+
+    atomic_store(&ring->written, 0);
+    atomic_store(&ring->stamp_count, 0);
+
+    memset(ring->samples, 0, sizeof(ring->samples));
+}
+
+// Called from the audio thread. Samples are published before the stamp and
+// the write counter, so the reader never sees a frame that isn't there yet.
+void
+SampleRingWrite(SampleRing *ring, const F32 *samples, U32 count, F64 time) {
+    U64 written = atomic_load_explicit(&ring->written, memory_order_relaxed);
+
+    if (count > SAMPLE_RING_CAPACITY) {
+        samples += count - SAMPLE_RING_CAPACITY;
+        written += count - SAMPLE_RING_CAPACITY;
+        count = SAMPLE_RING_CAPACITY;
+    }
+
+    U32 start = written % SAMPLE_RING_CAPACITY;
+    U32 first = MinU32(count, SAMPLE_RING_CAPACITY - start);
+
+    memcpy(ring->samples + start, samples, first * sizeof(F32));
+    memcpy(ring->samples, samples + first, (count - first) * sizeof(F32));
+
+    written += count;
+
+    U32 stamp = atomic_load_explicit(&ring->stamp_count, memory_order_relaxed);
+    ring->stamps[stamp % SAMPLE_RING_STAMPS] =
+        (SampleRingStamp){.frame = written, .time = time};
+
+    atomic_store_explicit(&ring->stamp_count, stamp + 1, memory_order_release);
+    atomic_store_explicit(&ring->written, written, memory_order_release);
+}
+
+U64
+SampleRingWritten(SampleRing *ring) {
+    return atomic_load_explicit(&ring->written, memory_order_acquire);
+}
+
+// Estimates the frame being heard at time now, given that a frame takes
+// latency seconds from being written to reaching the speakers. Each recent
+// stamp extrapolates forward at the ring rate; averaging them smooths out the
+// burstiness of audio callbacks.
+U64
+SampleRingPlayhead(SampleRing *ring, F64 now, F64 latency) {
+    U64 written = SampleRingWritten(ring);
+    U32 stamp_count =
+        atomic_load_explicit(&ring->stamp_count, memory_order_acquire);
+
+    F64 sum = 0.0;
+    U32 used = 0;
+
+    for (U32 i = 0; i < MinU32(stamp_count, SAMPLE_RING_STAMPS); ++i) {
+        SampleRingStamp stamp =
+            ring->stamps[(stamp_count - 1 - i) % SAMPLE_RING_STAMPS];
+
+        if (i > 0 && now - stamp.time > SAMPLE_RING_STAMP_AGE) {
+            break;
+        }
+
+        sum += stamp.frame + (now - stamp.time - latency) * ring->rate;
+        used++;
+    }
+
+    if (used == 0) {
+        return written;
+    }
+
+    F64 playhead = sum / used;
+
+    if (playhead < 0.0) {
+        return 0;
+    }
+
+    if (playhead > written) {
+        return written;
+    }
+
+    return playhead;
+}
+
+// Copies the count frames that end just before frame end. Frames that were
+// never written, or have already been overwritten, read as silence.
+void
+SampleRingRead(SampleRing *ring, U64 end, F32 *out, U32 count) {
+    U64 written = SampleRingWritten(ring);
+    U64 oldest =
+        written > SAMPLE_RING_CAPACITY ? written - SAMPLE_RING_CAPACITY : 0;
+
+    for (U32 i = 0; i < count;) {
+        I64 frame = (I64)end - count + i;
+
+        if (frame < (I64)oldest || frame >= (I64)written) {
+            out[i++] = 0.0f;
+            continue;
+        }
+
+        U32 start = frame % SAMPLE_RING_CAPACITY;
+        U32 run = MinU32(count - i, SAMPLE_RING_CAPACITY - start);
+        run = MinU32(run, written - frame);
+
+        memcpy(out + i, ring->samples + start, run * sizeof(F32));
+        i += run;
+    }
+}
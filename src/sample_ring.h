@@ -0,0 +1,43 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "defines.h"
+
+// Enough for one analysis window plus about a second of latency
+// compensation at the highest supported analysis rate.
+#define SAMPLE_RING_CAPACITY (1 << 18)
+#define SAMPLE_RING_STAMPS 16
+
+// Stamps older than this are ignored when estimating the playhead.
+#define SAMPLE_RING_STAMP_AGE 0.25
+
+typedef struct SampleRingStamp {
+    U64 frame;
+    F64 time;
+} SampleRingStamp;
+
+// Single producer, single consumer ring of mono samples at the analysis rate.
+// Every write is stamped with the time it was delivered, which lets the reader
+// work out which frame is audible at any later time.
+typedef struct SampleRing {
+    U32 rate;
+
+    _Atomic U64 written;
+    _Atomic U32 stamp_count;
+
+    SampleRingStamp stamps[SAMPLE_RING_STAMPS];
+
+    F32 samples[SAMPLE_RING_CAPACITY];
+} SampleRing;
+
+void
+SampleRingReset(SampleRing *ring, U32 rate);
+void
+SampleRingWrite(SampleRing *ring, const F32 *samples, U32 count, F64 time);
+U64
+SampleRingWritten(SampleRing *ring);
+U64
+SampleRingPlayhead(SampleRing *ring, F64 now, F64 latency);
+void
+SampleRingRead(SampleRing *ring, U64 end, F32 *out, U32 count);
@@ -1,5 +1,7 @@
+#include "alloc.h"
 #include "arena.h"
 #include "defines.h"
+#include "free_list.h"
 #include "thread.h"
 
 #include "server.h"
@@ -10,12 +12,24 @@
 #include <string.h>
 #include <unistd.h>
 
+// Both kinds of async request share one pool. data is NULL for a GET.
+typedef struct ServerRequest {
+    ServerData *server_data;
+    char       *endpoint;
+    const char *data;
+    char        response[SERVER_RESPONSE_SIZE];
+    void       *user_data;
+
+    void (*callback)(void *user_data, char *response);
+} ServerRequest;
+
 static inline U32
 WriteFunc(void *data, U32 size, U32 nmemb, void *p_client) {
     U32     write_size = size * nmemb;
     Memory *mem = (Memory *)p_client;
 
-    char *ptr = realloc(mem->response, mem->size + write_size + 1);
+    char *ptr = AllocRealloc(AllocTag_SERVER, mem->response,
+                             mem->size + write_size + 1);
     if (ptr == NULL) {
         return 0;
     }
@@ -33,11 +47,14 @@ ServerInitialise(ServerData *server_data, const char *uri, MemoryArena *arena) {
     server_data->curl = curl_easy_init();
     server_data->uri = uri;
     server_data->thread = ThreadAlloc(arena);
+
+    FreeListInitialiseType(&server_data->requests, ServerRequest, arena);
 }
 
 void
 ServerDestroy(ServerData *server_data) {
     curl_easy_cleanup(server_data->curl);
+    FreeListDestroy(&server_data->requests);
 }
 
 static inline void
@@ -58,7 +75,7 @@ ServerGet(ServerData *server_data, char *endpoint, char *response) {
 
     if (server_data->curl) {
         Memory mem;
-        mem.response = malloc(1);
+        mem.response = AllocMalloc(AllocTag_SERVER, 1);
         mem.size = 0;
 
         curl_easy_setopt(server_data->curl, CURLOPT_URL, url);
@@ -73,29 +90,27 @@ ServerGet(ServerData *server_data, char *endpoint, char *response) {
             strcpy(response, mem.response);
         }
 
-        free(mem.response);
+        AllocFree(AllocTag_SERVER, mem.response);
     }
 }
 
-typedef struct GetRequestArgs {
-    ServerData *server_data;
-    char       *endpoint;
-    char       *response;
-    void       *user_data;
-
-    void (*callback)(void *user_data, char *response);
-} GetRequestArgs;
-
-static inline void *
-GetRequestThread(void *data) {
-    GetRequestArgs *args = (GetRequestArgs *)data;
+static void *
+RequestThread(void *data) {
+    ServerRequest *request = (ServerRequest *)data;
 
-    ServerGet(args->server_data, args->endpoint, args->response);
+    if (request->data) {
+        ServerPost(request->server_data, request->endpoint, request->data,
+                   request->response);
+    } else {
+        ServerGet(request->server_data, request->endpoint, request->response);
+    }
 
-    if (args->callback) {
-        args->callback(args->user_data, args->response);
+    if (request->callback) {
+        request->callback(request->user_data, request->response);
     }
 
+    FreeListFree(&request->server_data->requests, request);
+
     return NULL;
 }
 
@@ -103,17 +118,16 @@ void
 ServerGetAsync(ServerData *server_data,
                char       *endpoint,
                void       *user_data,
-               void (*callback)(void *user_data, char *response),
-               MemoryArena *arena) {
-    GetRequestArgs *args = ArenaPushStruct(arena, GetRequestArgs);
+               void (*callback)(void *user_data, char *response)) {
+    ServerRequest *request =
+        FreeListAllocStruct(&server_data->requests, ServerRequest);
 
-    args->server_data = server_data;
-    args->endpoint = endpoint;
-    args->response = ArenaPushArray(arena, 1024, char);
-    args->user_data = user_data;
-    args->callback = callback;
+    request->server_data = server_data;
+    request->endpoint = endpoint;
+    request->user_data = user_data;
+    request->callback = callback;
 
-    ThreadCreate(server_data->thread, GetRequestThread, args);
+    ThreadCreate(server_data->thread, RequestThread, request);
 }
 
 void
@@ -128,7 +142,7 @@ ServerPost(ServerData *server_data,
 
     if (server_data->curl) {
         Memory mem;
-        mem.response = malloc(1);
+        mem.response = AllocMalloc(AllocTag_SERVER, 1);
         mem.size = 0;
 
         struct curl_slist *headers = NULL;
@@ -149,53 +163,34 @@ ServerPost(ServerData *server_data,
             strcpy(response, mem.response);
         }
 
-        free(mem.response);
+        AllocFree(AllocTag_SERVER, mem.response);
     }
 }
 
-typedef struct PostRequestArgs {
-    ServerData *server_data;
-    char       *endpoint;
-    const char *data;
-    char       *response;
-    void       *user_data;
-
-    void (*callback)(void *user_data, char *response);
-} PostRequestArgs;
-
-void *
-PostRequestThread(void *data) {
-    PostRequestArgs *args = (PostRequestArgs *)data;
-
-    ServerPost(args->server_data, args->endpoint, args->data, args->response);
-
-    if (args->callback) {
-        args->callback(args->user_data, args->response);
-    }
-
-    return NULL;
-}
-
 void
 ServerPostAsync(ServerData *server_data,
                 char       *endpoint,
                 const char *data,
                 void       *user_data,
-                void (*callback)(void *user_data, char *response),
-                MemoryArena *arena) {
-    PostRequestArgs *args = ArenaPushStruct(arena, PostRequestArgs);
-
-    args->server_data = server_data;
-    args->endpoint = endpoint;
-    args->data = data;
-    args->response = ArenaPushArray(arena, 1024, char);
-    args->user_data = user_data;
-    args->callback = callback;
-
-    ThreadCreate(server_data->thread, PostRequestThread, args);
+                void (*callback)(void *user_data, char *response)) {
+    ServerRequest *request =
+        FreeListAllocStruct(&server_data->requests, ServerRequest);
+
+    request->server_data = server_data;
+    request->endpoint = endpoint;
+    request->data = data;
+    request->user_data = user_data;
+    request->callback = callback;
+
+    ThreadCreate(server_data->thread, RequestThread, request);
 }
 
 void
 ServerWait(ServerData *server_data) {
     ThreadJoin(server_data->thread);
 }
+
+void
+ServerReport(ServerData *server_data) {
+    FreeListReport(&server_data->requests);
+}
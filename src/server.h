@@ -2,14 +2,20 @@
 
 #include "arena.h"
 #include "defines.h"
+#include "free_list.h"
 #include "thread.h"
 
 #include <curl/curl.h>
 
+#define SERVER_RESPONSE_SIZE 1024
+
 typedef struct ServerData {
     CURL       *curl;
     const char *uri;
     Thread     *thread;
+
+    // In-flight async requests, returned once their callback has run.
+    FreeList requests;
 } ServerData;
 
 typedef struct Memory {
@@ -26,8 +32,7 @@ void ServerGet(ServerData *server_data, char *endpoint, char *response);
 void ServerGetAsync(ServerData *server_data,
                     char       *endpoint,
                     void       *user_data,
-                    void (*callback)(void *user_data, char *response),
-                    MemoryArena *arena);
+                    void (*callback)(void *user_data, char *response));
 
 void ServerPost(ServerData *server_data,
                 const char *endpoint,
@@ -38,7 +43,7 @@ void ServerPostAsync(ServerData *server_data,
                      char       *endpoint,
                      const char *data,
                      void       *user_data,
-                     void (*callback)(void *user_data, char *response),
-                     MemoryArena *arena);
+                     void (*callback)(void *user_data, char *response));
 
 void ServerWait(ServerData *server_data);
+void ServerReport(ServerData *server_data);
@@ -27,17 +27,42 @@ SignalsProcessSamples(F32  scale,
                       U32  filter_count,
                       U32  velocity,
                       B8   zero_freq) {
-    *out_frequency_count =
-        logf((0.5f * (F32)sample_count) / start_frequency) / logf(scale);
+    U32 spectrum_count =
+        SignalsSpectrumCount(scale, start_frequency, sample_count);
 
     if (out_frequencies == NULL) {
-        for (U32 i = 0; i < smoothing; ++i) {
-            SignalsSmoothConvolve(NULL, *out_frequency_count, NULL,
-                                  filter_count, NULL, out_frequency_count);
-        }
+        SignalsApplySpectrum(NULL, spectrum_count, NULL, out_frequency_count,
+                             dt, smoothing, filter, filter_count, velocity,
+                             zero_freq);
         return;
     }
 
+    F32 spectrum[spectrum_count];
+
+    SignalsSpectrum(scale, start_frequency, samples, sample_count, spectrum);
+    SignalsApplySpectrum(spectrum, spectrum_count, out_frequencies,
+                         out_frequency_count, dt, smoothing, filter,
+                         filter_count, velocity, zero_freq);
+}
+
+// Number of logarithmic bins SignalsSpectrum produces, before smoothing.
+U32
+SignalsSpectrumCount(F32 scale, F32 start_frequency, U32 sample_count) {
+    return logf((0.5f * (F32)sample_count) / start_frequency) / logf(scale);
+}
+
+// The per-window half of SignalsProcessSamples: logarithmic bins of the log
+// power spectrum, relative to the loudest bin. Depends only on the samples,
+// so it can be computed ahead of time.
+void
+SignalsSpectrum(F32  scale,
+                F32  start_frequency,
+                F32 *samples,
+                U32  sample_count,
+                F32 *out_spectrum) {
+    U32 spectrum_count =
+        SignalsSpectrumCount(scale, start_frequency, sample_count);
+
     F32 max_amp = 0.0f;
 
     F32           window_buffer[sample_count];
@@ -53,9 +78,7 @@ SignalsProcessSamples(F32  scale,
         }
     }
 
-    F32 log_freq[*out_frequency_count];
-
-    for (U32 i = 0; i < *out_frequency_count; ++i) {
+    for (U32 i = 0; i < spectrum_count; ++i) {
         U32 f = powf(scale, i) * start_frequency;
 
         F32 a = SignalsCAmp(frequencies[f]);
@@ -65,9 +88,38 @@ SignalsProcessSamples(F32  scale,
             }
         }
 
-        log_freq[i] = a / max_amp;
+        out_spectrum[i] = a / max_amp;
+    }
+}
+
+// The per-frame half: smooths spectrum across bins and eases out_frequencies
+// towards it. Pass NULL for spectrum to only compute out_frequency_count.
+void
+SignalsApplySpectrum(F32 *spectrum,
+                     U32  spectrum_count,
+                     F32 *out_frequencies,
+                     U32 *out_frequency_count,
+                     F32  dt,
+                     U32  smoothing,
+                     F32 *filter,
+                     U32  filter_count,
+                     U32  velocity,
+                     B8   zero_freq) {
+    *out_frequency_count = spectrum_count;
+
+    if (spectrum == NULL || out_frequencies == NULL) {
+        for (U32 i = 0; i < smoothing; ++i) {
+            SignalsSmoothConvolve(NULL, *out_frequency_count, NULL,
+                                  filter_count, NULL, out_frequency_count);
+        }
+        return;
     }
 
+    // Smoothing grows the bin count, so work on a copy with room for it.
+    F32 log_freq[spectrum_count + smoothing * filter_count];
+
+    memcpy(log_freq, spectrum, spectrum_count * sizeof(F32));
+
     for (U32 i = 0; i < smoothing; ++i) {
         SignalsSmoothConvolve(log_freq, *out_frequency_count, filter,
                               filter_count, log_freq, out_frequency_count);
@@ -19,6 +19,26 @@ SignalsProcessSamples(F32  scale,
                       U32  velocity,
                       B8   zero_freq);
 
+U32
+SignalsSpectrumCount(F32 scale, F32 start_frequency, U32 sample_count);
+void
+SignalsSpectrum(F32  scale,
+                F32  start_frequency,
+                F32 *samples,
+                U32  sample_count,
+                F32 *out_spectrum);
+void
+SignalsApplySpectrum(F32 *spectrum,
+                     U32  spectrum_count,
+                     F32 *out_frequencies,
+                     U32 *out_frequency_count,
+                     F32  dt,
+                     U32  smoothing,
+                     F32 *filter,
+                     U32  filter_count,
+                     U32  velocity,
+                     B8   zero_freq);
+
 void
 SignalsWindowSamples(F32 *in, F32 *out, U32 length);
 void
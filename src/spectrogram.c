@@ -0,0 +1,306 @@
+#include "spectrogram.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "arena.h"
+#include "defines.h"
+#include "filesystem.h"
+#include "lmath.h"
+#include "pcm_cache.h"
+#include "pool.h"
+#include "signals.h"
+#include "thread.h"
+
+static void
+Unmap(Spectrogram *spectrogram) {
+    FSUnmapFile(spectrogram->map, spectrogram->map_size);
+
+    spectrogram->map = NULL;
+    spectrogram->map_size = 0;
+    spectrogram->frames = NULL;
+    spectrogram->frame_count = 0;
+}
+
+// Maps file if it was built from the same track with the same settings.
+static B8
+Map(Spectrogram *spectrogram, const char *file) {
+    spectrogram->map = FSMapFile(file, &spectrogram->map_size);
+
+    if (!spectrogram->map) {
+        return false;
+    }
+
+    const SpectrogramHeader *header = spectrogram->map;
+
+    if (spectrogram->map_size < sizeof(SpectrogramHeader) ||
+        header->magic != SPECTROGRAM_MAGIC ||
+        header->version != SPECTROGRAM_VERSION ||
+        header->sample_rate != spectrogram->sample_rate ||
+        header->window != SAMPLE_COUNT || header->hop != spectrogram->hop ||
+        header->bins != spectrogram->bins || header->scale != LOG_MUL ||
+        header->start_frequency != START_FREQ ||
+        header->key != spectrogram->key ||
+        spectrogram->map_size !=
+            sizeof(SpectrogramHeader) +
+                header->frame_count * header->bins * sizeof(I16)) {
+        Unmap(spectrogram);
+        return false;
+    }
+
+    spectrogram->frames = (const I16 *)(header + 1);
+    spectrogram->frame_count = header->frame_count;
+
+    return true;
+}
+
+// Pool job. Analyses one chunk of frames and writes it to its slot in the
+// temporary file; chunks never overlap, so jobs don't coordinate.
+static void
+BuildChunk(void *user_data, U32 index) {
+    Spectrogram *spectrogram = user_data;
+
+    U32 bins = spectrogram->bins;
+    U64 first = (U64)index * SPECTROGRAM_CHUNK_FRAMES;
+    U32 count = MinU64(SPECTROGRAM_CHUNK_FRAMES,
+                       spectrogram->frame_count - first);
+
+    F32 window[SAMPLE_COUNT];
+    F32 spectrum[bins];
+    I16 out[count * bins];
+
+    for (U32 k = 0; k < count; ++k) {
+        if (atomic_load(&spectrogram->cancelled)) {
+            return;
+        }
+
+        // Frame k covers the window that ends at its hop.
+        I64 end = (first + k) * spectrogram->hop;
+
+        for (U32 i = 0; i < SAMPLE_COUNT; ++i) {
+            I64 s = end - SAMPLE_COUNT + i;
+
+            window[i] = s >= 0 && s < (I64)spectrogram->pcm_count
+                            ? spectrogram->pcm[s] / 32768.0f
+                            : 0.0f;
+        }
+
+        SignalsSpectrum(LOG_MUL, START_FREQ, window, SAMPLE_COUNT, spectrum);
+
+        for (U32 i = 0; i < bins; ++i) {
+            out[k * bins + i] =
+                isfinite(spectrum[i])
+                    ? ClampF32(spectrum[i] * SPECTROGRAM_ONE, -32767, 32767)
+                    : SPECTROGRAM_EMPTY;
+        }
+    }
+
+    FILE *fptr = fopen(spectrogram->tmp, "r+b");
+
+    if (fptr) {
+        fseek(fptr, sizeof(SpectrogramHeader) + first * bins * sizeof(I16),
+              SEEK_SET);
+        fwrite(out, sizeof(I16), count * bins, fptr);
+        fclose(fptr);
+    }
+
+    atomic_store(&spectrogram->progress,
+                 (F32)(atomic_fetch_add(&spectrogram->chunks_done, 1) + 1) /
+                     spectrogram->chunk_count);
+}
+
+// Lays out the temporary file at full size, then fills it in parallel.
+static B8
+Build(Spectrogram *spectrogram, const char *file) {
+    U64       pcm_size;
+    const U8 *pcm = FSMapFile(spectrogram->source, &pcm_size);
+
+    if (!pcm || pcm_size < sizeof(PcmCacheHeader)) {
+        FSUnmapFile(pcm, pcm_size);
+        return false;
+    }
+
+    spectrogram->pcm = (const I16 *)(pcm + sizeof(PcmCacheHeader));
+    spectrogram->pcm_count = ((const PcmCacheHeader *)pcm)->frame_count;
+    spectrogram->frame_count = spectrogram->pcm_count / spectrogram->hop + 1;
+    spectrogram->chunk_count =
+        (spectrogram->frame_count + SPECTROGRAM_CHUNK_FRAMES - 1) /
+        SPECTROGRAM_CHUNK_FRAMES;
+    atomic_store(&spectrogram->chunks_done, 0);
+
+    SpectrogramHeader header = {.magic = SPECTROGRAM_MAGIC,
+                                .version = SPECTROGRAM_VERSION,
+                                .sample_rate = spectrogram->sample_rate,
+                                .window = SAMPLE_COUNT,
+                                .hop = spectrogram->hop,
+                                .bins = spectrogram->bins,
+                                .scale = LOG_MUL,
+                                .start_frequency = START_FREQ,
+                                .frame_count = spectrogram->frame_count,
+                                .key = spectrogram->key};
+
+    snprintf(spectrogram->tmp, sizeof(spectrogram->tmp), "%s.tmp", file);
+
+    FILE *fptr = fopen(spectrogram->tmp, "wb");
+    B8    ok = fptr != NULL;
+
+    if (ok) {
+        fwrite(&header, sizeof(header), 1, fptr);
+        fseek(fptr,
+              sizeof(header) +
+                  spectrogram->frame_count * spectrogram->bins * sizeof(I16) -
+                  1,
+              SEEK_SET);
+        fputc(0, fptr);
+        ok = fclose(fptr) == 0;
+    }
+
+    if (ok) {
+        PoolRun(&spectrogram->pool, spectrogram->chunk_count, BuildChunk,
+                spectrogram);
+        ok = !atomic_load(&spectrogram->cancelled);
+    }
+
+    FSUnmapFile(pcm, pcm_size);
+    spectrogram->pcm = NULL;
+    spectrogram->frame_count = 0;
+
+    if (!ok || rename(spectrogram->tmp, file) != 0) {
+        remove(spectrogram->tmp);
+        return false;
+    }
+
+    return true;
+}
+
+static void *
+SpectrogramThread(void *data) {
+    Spectrogram *spectrogram = data;
+
+    char file[700];
+    snprintf(file, sizeof(file), "%s/%016llx-%u-%u-%u.spec",
+             spectrogram->directory, (unsigned long long)spectrogram->key,
+             spectrogram->sample_rate, SAMPLE_COUNT, spectrogram->hop);
+
+    if (!Map(spectrogram, file) &&
+        (!Build(spectrogram, file) || !Map(spectrogram, file))) {
+        atomic_store(&spectrogram->status, SpectrogramStatus_FAILED);
+        return NULL;
+    }
+
+    atomic_store(&spectrogram->progress, 1.0f);
+    atomic_store(&spectrogram->status, SpectrogramStatus_READY);
+
+    return NULL;
+}
+
+void
+SpectrogramInitialise(Spectrogram *spectrogram, MemoryArena *arena) {
+    memset(spectrogram, 0, sizeof(Spectrogram));
+
+    spectrogram->thread = ThreadAlloc(arena);
+    PoolInitialise(&spectrogram->pool, 0, arena);
+}
+
+void
+SpectrogramDestroy(Spectrogram *spectrogram) {
+    atomic_store(&spectrogram->cancelled, true);
+
+    if (spectrogram->running) {
+        ThreadJoin(spectrogram->thread);
+    }
+
+    PoolDestroy(&spectrogram->pool);
+    Unmap(spectrogram);
+}
+
+// Starts opening or building the spectrogram for the track pcm holds, which
+// must be ready. Safe to call every frame: it does nothing if that track is
+// already current, and a build for another track is cancelled first.
+void
+SpectrogramRequest(Spectrogram *spectrogram, PcmCache *pcm) {
+    B8 same = spectrogram->key == pcm->key &&
+              spectrogram->sample_rate == pcm->sample_rate &&
+              strcmp(spectrogram->path, pcm->path) == 0;
+
+    if (spectrogram->running) {
+        if (!same) {
+            atomic_store(&spectrogram->cancelled, true);
+        }
+        return;
+    }
+
+    if (same && atomic_load(&spectrogram->status) != SpectrogramStatus_IDLE) {
+        return;
+    }
+
+    Unmap(spectrogram);
+
+    strcpy(spectrogram->path, pcm->path);
+    strcpy(spectrogram->source, pcm->file);
+    spectrogram->key = pcm->key;
+    spectrogram->sample_rate = pcm->sample_rate;
+    spectrogram->hop = pcm->sample_rate / RENDER_FPS;
+    spectrogram->bins = SignalsSpectrumCount(LOG_MUL, START_FREQ, SAMPLE_COUNT);
+
+    // Built here because TextFormat isn't safe off the main thread.
+    FSGetApolloDirectory(spectrogram->directory);
+    strcat(spectrogram->directory, "/spectrograms");
+
+    atomic_store(&spectrogram->cancelled, false);
+    atomic_store(&spectrogram->progress, 0.0f);
+    atomic_store(&spectrogram->status, SpectrogramStatus_BUILDING);
+
+    spectrogram->running = true;
+    ThreadCreate(spectrogram->thread, SpectrogramThread, spectrogram);
+}
+
+// Call once per frame to reap the build thread. A cancelled build leaves the
+// spectrogram idle so the next request starts over.
+SpectrogramStatus
+SpectrogramUpdate(Spectrogram *spectrogram) {
+    SpectrogramStatus status = atomic_load(&spectrogram->status);
+
+    if (!spectrogram->running || status == SpectrogramStatus_BUILDING) {
+        return status;
+    }
+
+    ThreadJoin(spectrogram->thread);
+    spectrogram->running = false;
+
+    if (atomic_load(&spectrogram->cancelled)) {
+        Unmap(spectrogram);
+        spectrogram->path[0] = 0;
+        atomic_store(&spectrogram->status, SpectrogramStatus_IDLE);
+    }
+
+    return atomic_load(&spectrogram->status);
+}
+
+B8
+SpectrogramReady(Spectrogram *spectrogram, const char *path) {
+    return !spectrogram->running &&
+           atomic_load(&spectrogram->status) == SpectrogramStatus_READY &&
+           strcmp(spectrogram->path, path) == 0;
+}
+
+// Fills out with the bins of the frame closest to the window ending at
+// sample. Returns false if sample is outside the track.
+B8
+SpectrogramLookup(Spectrogram *spectrogram, I64 sample, F32 *out) {
+    I64 frame = (sample + spectrogram->hop / 2) / spectrogram->hop;
+
+    if (sample < 0 || frame >= (I64)spectrogram->frame_count) {
+        return false;
+    }
+
+    const I16 *bins = spectrogram->frames + frame * spectrogram->bins;
+
+    for (U32 i = 0; i < spectrogram->bins; ++i) {
+        out[i] = bins[i] == SPECTROGRAM_EMPTY ? -INFINITY
+                                              : bins[i] / SPECTROGRAM_ONE;
+    }
+
+    return true;
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <stdatomic.h>
+
+#include "arena.h"
+#include "defines.h"
+#include "pcm_cache.h"
+#include "pool.h"
+#include "thread.h"
+
+#define SPECTROGRAM_MAGIC 0x43505341 // "ASPC"
+#define SPECTROGRAM_VERSION 1
+
+// Frames per job when building. Each job writes one contiguous chunk.
+#define SPECTROGRAM_CHUNK_FRAMES 256
+
+// Bins are stored in fixed point with this many steps per unit. Bins the FFT
+// couldn't measure, e.g. in digital silence, are stored as SPECTROGRAM_EMPTY.
+#define SPECTROGRAM_ONE 8192.0f
+#define SPECTROGRAM_EMPTY INT16_MIN
+
+typedef struct SpectrogramHeader {
+    U32 magic;
+    U32 version;
+    U32 sample_rate;
+    U32 window;
+    U32 hop;
+    U32 bins;
+    F32 scale;
+    F32 start_frequency;
+    U64 frame_count;
+    U64 key;
+} SpectrogramHeader;
+
+typedef enum SpectrogramStatus {
+    SpectrogramStatus_IDLE = 0,
+    SpectrogramStatus_BUILDING,
+    SpectrogramStatus_READY,
+    SpectrogramStatus_FAILED,
+} SpectrogramStatus;
+
+// SignalsSpectrum of a whole track, one frame per 1/RENDER_FPS seconds,
+// built from the PCM cache on a worker pool and stored next to it in
+// ~/.config/apollo/spectrograms. The file is keyed by the track hash and the
+// analysis settings, and mapped, so looking up a frame costs a copy instead of
+// an FFT.
+typedef struct Spectrogram {
+    Thread *thread;
+    B8      running;
+    Pool    pool;
+
+    _Atomic I32 status;
+    _Atomic F32 progress;
+    _Atomic I32 cancelled;
+
+    char path[256];
+    char source[600];
+    char directory[512];
+    U64  key;
+    U32  sample_rate;
+    U32  hop;
+    U32  bins;
+
+    // Valid once status is READY.
+    const void *map;
+    U64         map_size;
+    const I16  *frames;
+    U64         frame_count;
+
+    // Only used while building.
+    char        tmp[620];
+    const I16  *pcm;
+    U64         pcm_count;
+    U32         chunk_count;
+    _Atomic U32 chunks_done;
+} Spectrogram;
+
+void
+SpectrogramInitialise(Spectrogram *spectrogram, MemoryArena *arena);
+void
+SpectrogramDestroy(Spectrogram *spectrogram);
+void
+SpectrogramRequest(Spectrogram *spectrogram, PcmCache *pcm);
+SpectrogramStatus
+SpectrogramUpdate(Spectrogram *spectrogram);
+B8
+SpectrogramReady(Spectrogram *spectrogram, const char *path);
+B8
+SpectrogramLookup(Spectrogram *spectrogram, I64 sample, F32 *out);
@@ -5,18 +5,21 @@
 #include <math.h>
 #include <raylib.h>
 #include <rlgl.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
 #include "animation.h"
 #include "api.h"
+#include "alloc.h"
 #include "arena.h"
 #include "defines.h"
 #include "ffmpeg.h"
 #include "filesystem.h"
 #include "handmademath.h"
 #include "hashmap.h"
+#include "intern.h"
 #include "lmath.h"
 #include "parameter.h"
 #include "permanent_storage.h"
@@ -27,6 +30,12 @@
 #include "thread.h"
 #include "ui.h"
 
+// Live recordings are encoded without audio, then muxed with the captured
+// input once they end.
+#define RECORD_OUTPUT "output.mp4"
+#define RECORD_LIVE_VIDEO "output.video.mp4"
+#define RECORD_LIVE_AUDIO "output.wav"
+
 #define RAYGUI_IMPLEMENTATION
 #include "raygui.h"
 
@@ -44,12 +53,22 @@ BeginRecording();
 static void
 EndRecording();
 static void
+JoinRecordingThread();
+static void
 UpdateRecording();
+static void
+UpdateLiveRecording();
 
 static void
 SetFrequencyCount();
 static B8
 GetDroppedFiles();
+static void
+UpdateTrackLoader();
+static void
+UpdatePlayback();
+static void
+SetCurrentTrack();
 
 static void
 FrameCallback(void *buffer_data, U32 n);
@@ -60,6 +79,25 @@ PrintEllipses(U32 max, F32 min, char buf[max + 1]);
 static void
 CreateFilter(F32 *filter, U32 filter_count);
 
+static void
+ResetMusicResampler();
+static F64
+AnalysisLatency();
+static void
+ReadAnalysisWindow(B8 compensate);
+static void
+UpdateHistory();
+static void
+UpdateFrequencies(I64 position, F32 dt);
+
+static void
+InitialiseRealtime();
+
+static F32
+GetDefParam(ParameterHandle handle);
+static void
+SetDefParam(ParameterHandle handle, F32 value);
+
 static void
 CircleFrequenciesProc(void *user_data);
 
@@ -108,15 +146,23 @@ CreateDirectories() {
     if (!DirectoryExists(TextFormat("%s/shaders", apollo))) {
         FSCreateDirectory(TextFormat("%s/shaders", apollo));
     }
+
+    if (!DirectoryExists(TextFormat("%s/pcm", apollo))) {
+        FSCreateDirectory(TextFormat("%s/pcm", apollo));
+    }
+
+    if (!DirectoryExists(TextFormat("%s/spectrograms", apollo))) {
+        FSCreateDirectory(TextFormat("%s/spectrograms", apollo));
+    }
 }
 
 static void
-FadeInAnimationUpdate(_Animation *anim, void *user_data, F64 dt) {
-    anim->val = sqrtf(1.0f - anim->elapsed / *(F32 *)user_data);
+FadeInAnimationUpdate(Animations *anims, U32 i, void *user_data, F64 dt) {
+    anims->val[i] = sqrtf(1.0f - anims->elapsed[i] / *(F32 *)user_data);
 
-    if (anim->val < 0.0) {
-        anim->val = 0.0f;
-        anim->finished = true;
+    if (anims->val[i] < 0.0) {
+        anims->val[i] = 0.0f;
+        anims->finished[i] = true;
     }
 }
 
@@ -124,55 +170,100 @@ void
 StateInitialise() {
     CreateDirectories();
 
-    // Initialising memory
-    memory.permanent_storage_size = 1024 * 1024 * 1024;
-    memory.permanent_storage =
-        PermanentStorageInit(memory.permanent_storage_size);
+    // Initialising memory. Storage is only reserved here; the arena commits
+    // it as it grows, State included.
+    PermanentStorageConfig config = PermanentStorageGetConfig();
+
+    memory.permanent_storage_size = config.size;
+    memory.permanent_storage = PermanentStorageInit(config);
+
+    if (!memory.permanent_storage) {
+        exit(1);
+    }
+
+    MemoryArena arena;
+    ArenaInitialiseReserved(&arena, memory.permanent_storage_size,
+                            memory.permanent_storage,
+                            config.huge_pages ? PERMANENT_STORAGE_HUGE_GRANULE
+                                              : PERMANENT_STORAGE_GRANULE);
+    arena.hint = "Set APOLLO_ARENA_SIZE to reserve more.";
 
-    state = (State *)memory.permanent_storage;
+    state = ArenaPushStruct(&arena, State);
+    state->arena = arena;
 
-    ArenaInitialise(&state->arena,
-                    memory.permanent_storage_size - sizeof(State),
-                    (U8 *)memory.permanent_storage + sizeof(State));
+    memory.transient_storage_size = TRANSIENT_STORAGE_SIZE;
+    memory.transient_storage = PermanentStorageInit(
+        (PermanentStorageConfig){.size = memory.transient_storage_size});
+
+    if (!memory.transient_storage) {
+        exit(1);
+    }
+
+    ArenaInitialiseReserved(&state->transient, memory.transient_storage_size,
+                            memory.transient_storage,
+                            PERMANENT_STORAGE_GRANULE);
+    state->transient.scratch = true;
 
     state->api_data = ArenaPushStruct(&state->arena, ApiData);
     state->renderer_data = ArenaPushStruct(&state->arena, RendererData);
     state->loopback_data = ArenaPushStruct_(&state->arena, LoopbackDataSize());
     state->server_data = ArenaPushStruct(&state->arena, ServerData);
+    state->loader = ArenaPushStruct(&state->arena, TrackLoader);
+    state->prefetch = ArenaPushStruct(&state->arena, TrackLoader);
+    state->player = ArenaPushStruct(&state->arena, Player);
+    state->playlist = ArenaPushStruct(&state->arena, Playlist);
+    state->pcm_cache = ArenaPushStruct(&state->arena, PcmCache);
+    state->spectrogram = ArenaPushStruct(&state->arena, Spectrogram);
+    state->capture = ArenaPushStruct(&state->arena, Capture);
+    state->stems = ArenaPushStruct(&state->arena, Stems);
+
+    TrackLoaderInitialise(state->loader, &state->arena);
+    TrackLoaderInitialise(state->prefetch, &state->arena);
+    state->resampler_front = 0;
+    state->resampler_middle = 1;
+    state->resampler_back = 2;
+
+    PlayerInitialise(state->player, FrameCallback, &state->arena);
+    PcmCacheInitialise(state->pcm_cache, &state->arena);
+    SpectrogramInitialise(state->spectrogram, &state->arena);
+    CaptureInitialise(state->capture, &state->arena);
+    StemsInitialise(state->stems, &state->arena);
+
+    InternInitialise(&state->arena);
 
     // Initialise default parameters
     {
-        state->parameters = ParameterCreate();
+        state->parameters = ArenaPushStruct(&state->arena, Parameters);
+        ParametersInitialise(state->parameters);
+
+        state->def_params.velocity =
+            ParameterRegister(state->parameters, "VELOCITY", 10.0f, 1, 100);
 
-        state->def_params.velocity = ParameterSet(
-            state->parameters,
-            &(Parameter){
-                .name = "VELOCITY", .value = 10.f, .min = 1, .max = 100});
+        state->def_params.smoothing =
+            ParameterRegister(state->parameters, "SMOOTHING", 5.0f, 1, 10);
 
-        state->def_params.smoothing = ParameterSet(
-            state->parameters,
-            &(Parameter){
-                .name = "SMOOTHING", .value = 5.0f, .min = 1, .max = 10});
+        state->def_params.master_volume = ParameterRegister(
+            state->parameters, "MASTER VOL", 100.0f, 0, 100);
 
-        state->def_params.master_volume = ParameterSet(
-            state->parameters,
-            &(Parameter){
-                .name = "MASTER VOL", .value = 100.0f, .min = 0, .max = 100});
+        // Extra delay (ms) between the audio device and the speakers, e.g.
+        // from a PA system.
+        state->def_params.av_offset =
+            ParameterRegister(state->parameters, "AV OFFSET", 0.0f, 0, 500);
     }
 
     // Initialise animations
-    state->animations = AnimationsCreate();
+    state->animations = ArenaPushStruct(&state->arena, Animations);
+    AnimationsInitialise(state->animations);
 
     {
-        state->procedures = ProcedureCreate();
+        state->procedures = ArenaPushStruct(&state->arena, Procedures);
+        ProceduresInitialise(state->procedures);
 
-        state->def_procs.circle_frequencies =
-            _ProcedureAdd(state->procedures, "_1", NULL, CircleFrequenciesProc,
-                          &state->arena);
+        state->def_procs.circle_frequencies = ProcedureAddRender(
+            state->procedures, "_1", NULL, CircleFrequenciesProc);
 
-        state->def_procs.normal_frequencies =
-            _ProcedureAdd(state->procedures, "_2", NULL, NormalFrequenciesProc,
-                          &state->arena);
+        state->def_procs.normal_frequencies = ProcedureAddRender(
+            state->procedures, "_2", NULL, NormalFrequenciesProc);
     }
 
     char apollo[512];
@@ -180,12 +271,30 @@ StateInitialise() {
     ApiInitialise(TextFormat("%s/%s", apollo, "init.lua"), state,
                   state->api_data);
 
+    state->analysis_rate =
+        ClampI32(state->api_data->data.opt.analysis_rate, 8000, 192000);
+
+    SampleRingReset(&state->ring, state->analysis_rate);
+
+    state->stems->sample_rate = state->analysis_rate;
+
+    state->history = ArenaPushStruct(&state->arena, History);
+    HistoryInitialise(
+        state->history, state->analysis_rate,
+        ClampF32(state->api_data->data.opt.history_seconds, 1.0f, 600.0f),
+        &state->arena);
+
+    InitialiseRealtime();
+
+    AllocSetChecking(state->api_data->data.opt.alloc_check);
+
     if (Deserialize()) {
         if (!FileExists(state->music_fp) || strlen(state->music_fp) == 0) {
             strcpy(state->music_fp, FSFormatAssetsDirectory("monks.mp3"));
         }
 
-        state->music = LoadMusicStream(state->music_fp);
+        PlaylistAdd(state->playlist, state->music_fp);
+        TrackLoaderRequest(state->loader, state->music_fp);
     }
 
     if (state->screen_size.Width <= 50.0f ||
@@ -214,21 +323,51 @@ StateInitialise() {
     SignalsProcessSamples(LOG_MUL, START_FREQ, 0, SAMPLE_COUNT, NULL,
                           &state->frequency_count, 0, 0, state->filter,
                           state->filter_count,
-                          _ParameterGetValue(state->def_params.velocity),
+                          GetDefParam(state->def_params.velocity),
                           state->zero_frequencies);
 
-    if (IsMusicReady(state->music)) {
-        PlayMusicStream(state->music);
-        AttachAudioStreamProcessor(state->music.stream, FrameCallback);
-    }
-
-    RendererInitialise(state->renderer_data);
+    RendererInitialise(state->renderer_data, &state->transient);
     LoopbackInitialise(state->loopback_data, state);
     ServerInitialise(state->server_data, API_URI, &state->arena);
 
     state->def_anims.fade_in =
         AnimationsAdd(state->animations, "fade_in", &(F32){0.74f},
-                      FadeInAnimationUpdate, &state->arena);
+                      FadeInAnimationUpdate);
+}
+
+// Applies lynx.opt's realtime settings to the threads that exist so far and
+// locks the buffers touched every audio period or frame.
+static void
+InitialiseRealtime() {
+    ApiInterface *api = &state->api_data->data;
+
+    RealtimeConfig config = {
+        .priority = ClampI32(api->opt.realtime_priority, 0, 99),
+        .audio_core = api->opt.audio_core,
+        .analysis_core = api->opt.analysis_core,
+    };
+
+    state->realtime = ArenaPushStruct(&state->arena, Realtime);
+    RealtimeInitialise(state->realtime, config);
+
+    if (!RealtimeEnabled(state->realtime)) {
+        return;
+    }
+
+    RealtimePromoteAnalysis(state->realtime, state->player->thread);
+
+    for (U32 i = 0; i < state->stems->pool.thread_count; ++i) {
+        RealtimePromoteAnalysis(state->realtime,
+                                state->stems->pool.threads[i]);
+    }
+
+    RealtimeLock(state->realtime, state, sizeof(State));
+    RealtimeLock(state->realtime, state->player, sizeof(Player));
+    RealtimeLock(state->realtime, state->stems, sizeof(Stems));
+    RealtimeLock(state->realtime, state->history->chunks,
+                 state->history->chunk_count * sizeof(HistoryChunk));
+
+    RealtimeReport(state->realtime);
 }
 
 static void
@@ -246,8 +385,12 @@ void
 StateDestroy() {
     ServerWait(state->server_data);
 
+    // Lets a live recording finish muxing rather than cutting it off.
+    JoinRecordingThread();
+
     Serialize();
 
+    ServerReport(state->server_data);
     ServerDestroy(state->server_data);
 
     ApiDestroy(state->api_data);
@@ -256,12 +399,24 @@ StateDestroy() {
 
     RendererDestroy(state->renderer_data);
 
-    ParameterDestroy(state->parameters);
+    ParametersDestroy(state->parameters);
+    InternDestroy();
+
+    TrackLoaderDestroy(state->loader);
+    TrackLoaderDestroy(state->prefetch);
+    SpectrogramDestroy(state->spectrogram);
+    StemsDestroy(state->stems);
+    PcmCacheDestroy(state->pcm_cache);
 
     UnloadStateFont(state->font);
-    UnloadMusicStream(state->music);
+    PlayerDestroy(state->player);
+
+    AllocReport();
 
-    PermanentStorageDestroy(memory.permanent_storage);
+    PermanentStorageDestroy(memory.transient_storage,
+                            memory.transient_storage_size);
+    PermanentStorageDestroy(memory.permanent_storage,
+                            memory.permanent_storage_size);
 }
 
 void
@@ -270,29 +425,42 @@ AddMetricCallback(void *user_data, char *response) {
 }
 
 static void
-FadeAnimationUpdate(_Animation *anim, void *user_data, F64 dt) {
-    anim->val = anim->elapsed / *(F32 *)user_data;
+FadeAnimationUpdate(Animations *anims, U32 i, void *user_data, F64 dt) {
+    anims->val[i] = anims->elapsed[i] / *(F32 *)user_data;
 
-    if (anim->val > 1.0) {
-        anim->val = 1.0f;
-        anim->finished = true;
+    if (anims->val[i] > 1.0) {
+        anims->val[i] = 1.0f;
+        anims->finished[i] = true;
     }
 }
 
 static void *
 EndRecordingThread(void *data) {
     EndRecording();
+    atomic_store(&state->record_data.ending, false);
     return NULL;
 }
 
-void
-EndRecordingAnimationUpdate(_Animation *anim, void *user_data, F64 dt) {
-    anim->val = (0.5f - anim->elapsed) / 0.5f;
+// Waits for the last recording to be finished off, if it is still going.
+static void
+JoinRecordingThread() {
+    if (state->record_data.joinable) {
+        ThreadJoin(state->recording_thread);
+        state->record_data.joinable = false;
+    }
+}
 
-    if (anim->elapsed >= 0.5) {
-        anim->val = 0.0f;
+void
+EndRecordingAnimationUpdate(Animations *anims,
+                            U32         i,
+                            void       *user_data,
+                            F64         dt) {
+    anims->val[i] = (0.5f - anims->elapsed[i]) / 0.5f;
+
+    if (anims->elapsed[i] >= 0.5) {
+        anims->val[i] = 0.0f;
         state->condition = StateCondition_NORMAL;
-        anim->finished = true;
+        anims->finished[i] = true;
     }
 }
 
@@ -300,27 +468,29 @@ void
 BeginExiting() {
     ServerPostAsync(state->server_data, "add-metric",
                     TextFormat("{\"time\": %f}", GetTime()),
-                    &state->should_close, AddMetricCallback, &state->arena);
+                    &state->should_close, AddMetricCallback);
 
     state->condition = StateCondition_EXITING;
     state->def_anims.exiting =
         AnimationsAdd(state->animations, "exiting", &(F32){1.0f},
-                      FadeAnimationUpdate, &state->arena);
+                      FadeAnimationUpdate);
 }
 
 void
-PopUpEnterAnimationUpdate(_Animation *anim, void *user_data, F64 dt) {
+PopUpEnterAnimationUpdate(Animations *anims, U32 i, void *user_data, F64 dt) {
     F32 length = *(F32 *)user_data;
 
-    anim->val = sin((PI * anim->elapsed) / (2 * length));
+    anims->val[i] = sin((PI * anims->elapsed[i]) / (2 * length));
 
-    if (anim->elapsed >= length) {
-        anim->finished = true;
+    if (anims->elapsed[i] >= length) {
+        anims->finished[i] = true;
     }
 }
 
 void
 StateAddPopUp(const char *text) {
+    AllocSettle();
+
     memcpy(state->pop_ups + 1, state->pop_ups,
            sizeof(StatePopUp) * (MAX_POP_UPS - 1));
 
@@ -332,21 +502,21 @@ StateAddPopUp(const char *text) {
 
     state->def_anims.pop_up =
         AnimationsAdd(state->animations, "pop up", &(F32){0.5},
-                      PopUpEnterAnimationUpdate, &state->arena);
+                      PopUpEnterAnimationUpdate);
 }
 
 void
-PopUpExitAnimationUpdate(_Animation *anim, void *user_data, F64 dt) {
+PopUpExitAnimationUpdate(Animations *anims, U32 i, void *user_data, F64 dt) {
     F32 length = *(F32 *)user_data;
 
-    anim->val = sin((PI * (length - anim->elapsed)) / (2 * length));
+    anims->val[i] = sin((PI * (length - anims->elapsed[i])) / (2 * length));
 
-    if (anim->elapsed >= length) {
+    if (anims->elapsed[i] >= length) {
         state->pop_up_count--;
         memcpy(state->pop_ups, state->pop_ups + 1,
                sizeof(StatePopUp) * (MAX_POP_UPS - 1));
 
-        anim->finished = true;
+        anims->finished[i] = true;
     }
 }
 
@@ -354,11 +524,16 @@ void
 StateRemovePopUp() {
     state->def_anims.pop_up_exit =
         AnimationsAdd(state->animations, "pop up exit", &(F32){0.25},
-                      PopUpExitAnimationUpdate, &state->arena);
+                      PopUpExitAnimationUpdate);
 }
 
 void
 StateUpdate() {
+    AllocFrameBegin();
+    ArenaReset(&state->transient);
+
+    RealtimeUpdate(state->realtime);
+
     ApiUpdate(state->api_data, state);
     AnimationsUpdate(state->animations);
 
@@ -370,13 +545,21 @@ StateUpdate() {
                 state->recording_thread = ThreadAlloc(&state->arena);
             }
 
+            // BeginRecording waited for the last one, so this doesn't block.
+            JoinRecordingThread();
+
+            atomic_store(&state->record_data.ending, true);
             ThreadCreate(state->recording_thread, EndRecordingThread, state);
+            state->record_data.joinable = true;
 
             state->def_anims.end_recording =
                 AnimationsAdd(state->animations, "end_recording", NULL,
-                              EndRecordingAnimationUpdate, &state->arena);
+                              EndRecordingAnimationUpdate);
 
-            ResumeMusicStream(state->music);
+            if (!state->record_data.live) {
+                ResetMusicResampler();
+                PlayerResume(state->player);
+            }
         } else {
             BeginExiting();
         }
@@ -388,36 +571,45 @@ StateUpdate() {
     case StateCondition_NORMAL: {
         ApiPreUpdate(state->api_data, state);
 
-        if (!IsMusicReady(state->music)) {
+        UpdateTrackLoader();
+
+        if (!PlayerIsReady(state->player)) {
             state->condition = StateCondition_LOAD;
             break;
         }
 
-        UpdateMusicStream(state->music);
+        UpdatePlayback();
 
         if (IsKeyPressed(KEY_R)) {
-            SeekMusicStream(state->music, 0);
+            PlayerSeek(state->player, 0);
+        }
+
+        if (IsKeyPressed(KEY_N) && PlayerSkip(state->player)) {
+            PlaylistAdvance(state->playlist);
+            SetCurrentTrack();
         }
 
 #if 0
         if (IsKeyPressed(KEY_L)) {
             if (state->loopback) {
-                AttachAudioStreamProcessor(state->music.stream, FrameCallback);
-                ResumeMusicStream(state->music);
+                AttachAudioStreamProcessor(state->player->stream,
+                                           FrameCallback);
+                PlayerResume(state->player);
                 state->loopback = false;
             } else {
-                DetachAudioStreamProcessor(state->music.stream, FrameCallback);
-                PauseMusicStream(state->music);
+                DetachAudioStreamProcessor(state->player->stream,
+                                           FrameCallback);
+                PlayerPause(state->player);
                 state->loopback = true;
             }
         }
 #endif
 
         if (IsKeyPressed(KEY_SPACE)) {
-            if (IsMusicStreamPlaying(state->music)) {
-                PauseMusicStream(state->music);
+            if (PlayerIsPlaying(state->player)) {
+                PlayerPause(state->player);
             } else {
-                ResumeMusicStream(state->music);
+                PlayerResume(state->player);
             }
         }
 
@@ -425,38 +617,38 @@ StateUpdate() {
             state->screen_size = HMM_V2(GetRenderWidth(), GetRenderHeight());
         }
 
-        SetMasterVolume(_ParameterGetValue(state->def_params.master_volume) /
-                        100.f);
+        SetMasterVolume(GetDefParam(state->def_params.master_volume) / 100.f);
 
         if (IsFileDropped()) {
-            if (!GetDroppedFiles()) {
-                state->condition = StateCondition_LOAD;
-            }
+            GetDroppedFiles();
         }
 
-        if (IsKeyPressed(KEY_B) && IsMusicReady(state->music)) {
+        if (IsKeyPressed(KEY_B) &&
+            (PlayerIsReady(state->player) || state->loopback)) {
             BeginRecording();
         }
 
         if (IsKeyPressed(KEY_M)) {
             if (IsKeyDown(KEY_LEFT_CONTROL)) {
                 state->render_ui = !state->render_ui;
-            } else if (IsMusicReady(state->music)) {
-                if (_ParameterGetValue(state->def_params.master_volume) !=
+            } else if (PlayerIsReady(state->player)) {
+                if (GetDefParam(state->def_params.master_volume) !=
                     0.f) {
-                    _ParameterSetValue(state->def_params.master_volume, 0.f);
+                    SetDefParam(state->def_params.master_volume, 0.f);
                 } else {
-                    _ParameterSetValue(state->def_params.master_volume, 100.f);
+                    SetDefParam(state->def_params.master_volume, 100.f);
                 }
             }
         }
 
-        SignalsProcessSamples(
-            LOG_MUL, START_FREQ, state->samples, SAMPLE_COUNT,
-            state->frequencies, &state->frequency_count, state->dt,
-            (U32)_ParameterGetValue(state->def_params.smoothing), state->filter,
-            state->filter_count, _ParameterGetValue(state->def_params.velocity),
-            state->zero_frequencies);
+        ReadAnalysisWindow(true);
+
+        UpdateFrequencies(
+            state->loopback ? -1
+                            : (PlayerTimePlayed(state->player) -
+                               AnalysisLatency()) *
+                                  state->analysis_rate,
+            state->dt);
 
     } break;
 
@@ -465,16 +657,21 @@ StateUpdate() {
 
     case StateCondition_LOAD: {
         if (IsFileDropped()) {
-            if (GetDroppedFiles()) {
-                state->condition = StateCondition_NORMAL;
-            }
+            GetDroppedFiles();
         }
+
+        UpdateTrackLoader();
     } break;
 
     case StateCondition_RECORDING: {
-        if (state->record_data.wave_cursor >=
-            state->record_data.wave.frameCount) {
+        if (state->record_data.live) {
+            UpdateLiveRecording();
+            break;
+        }
+
+        if (state->record_data.cursor >= state->pcm_cache->frame_count) {
             EndRecording();
+            ResetMusicResampler();
             state->condition = StateCondition_NORMAL;
         }
 
@@ -504,11 +701,11 @@ StateRender() {
             XLargeFont(state->font), TextFormat("Exiting%s", buf),
             HMM_V2(state->screen_size.Width / 2, state->screen_size.Height / 2),
             (Color){255, 255, 255,
-                    255 * AnimationsLoad_(state->animations,
+                    255 * AnimationsLoad(state->animations,
                                           state->def_anims.exiting)});
     } break;
     case StateCondition_NORMAL: {
-        if (!IsMusicReady(state->music)) {
+        if (!PlayerIsReady(state->player)) {
             state->condition = StateCondition_LOAD;
             break;
         }
@@ -519,22 +716,31 @@ StateRender() {
         if (state->render_ui) {
             RenderUI();
 
+            if (TrackLoaderBusy(state->loader)) {
+                UIRenderProgress(
+                    TrackLoaderProgress(state->loader),
+                    TextFormat("Loading %s", GetFileName(state->loader->path)),
+                    HMM_V2(state->screen_size.Width / 2,
+                           state->screen_size.Height - 40),
+                    200, state->font);
+            }
+
             // Render Pop-Ups
             if (state->pop_up_count > 0 && state->ui) {
                 F32 pop_up_padding = 25;
                 F32 pop_up_height = 50;
 
                 F32 offset = 0;
-                if (AnimationsExists_(state->animations,
+                if (AnimationsExists(state->animations,
                                       state->def_anims.pop_up)) {
                     offset = (1 / 2.f) * (pop_up_height + pop_up_padding) *
-                             (AnimationsLoad_(state->animations,
+                             (AnimationsLoad(state->animations,
                                               state->def_anims.pop_up) -
                               1);
-                } else if (AnimationsExists_(state->animations,
+                } else if (AnimationsExists(state->animations,
                                              state->def_anims.pop_up_exit)) {
                     offset = (1 / 2.f) * (pop_up_height + pop_up_padding) *
-                             (AnimationsLoad_(state->animations,
+                             (AnimationsLoad(state->animations,
                                               state->def_anims.pop_up_exit) -
                               1);
                 }
@@ -551,7 +757,7 @@ StateRender() {
                 if (UIRenderPopUp(border_size, pop_up_height, pop_up_padding,
                                   offset, 255, state->screen_size, state->font,
                                   &state->pop_ups[0], true) &&
-                    !AnimationsExists_(state->animations,
+                    !AnimationsExists(state->animations,
                                        state->def_anims.pop_up_exit)) {
                     StateRemovePopUp();
                 }
@@ -560,6 +766,16 @@ StateRender() {
     } break;
 
     case StateCondition_LOAD: {
+        if (TrackLoaderBusy(state->loader)) {
+            UIRenderProgress(
+                TrackLoaderProgress(state->loader),
+                TextFormat("Loading %s", GetFileName(state->loader->path)),
+                HMM_V2(state->screen_size.Width / 2,
+                       state->screen_size.Height / 2),
+                300, state->font);
+            break;
+        }
+
         RendererDrawTextCenter(
             MediumFont(state->font), "Drag & drop music to play",
             HMM_V2(state->screen_size.Width / 2, state->screen_size.Height / 2),
@@ -572,7 +788,7 @@ StateRender() {
 
         F64 alpha = 1.0f;
 
-        AnimationsApply(state->animations, state->def_anims.recording->name,
+        AnimationsApply(state->animations, state->def_anims.recording,
                         &alpha);
 
         RendererDrawTextCenter(
@@ -586,7 +802,19 @@ StateRender() {
 
             Render();
         }
-        RendererEndRecording(state->renderer_data, state->ffmpeg);
+        U32 copies = 1;
+
+        if (state->record_data.live) {
+            U64 due = (GetTime() - state->record_start) * RENDER_FPS + 1;
+
+            copies = due > state->record_data.frames
+                         ? due - state->record_data.frames
+                         : 0;
+        }
+
+        state->record_data.frames += copies;
+
+        RendererEndRecording(state->renderer_data, state->ffmpeg, copies);
 
     } break;
 
@@ -595,14 +823,16 @@ StateRender() {
         break;
     }
 
-    if (AnimationsExists_(state->animations, state->def_anims.fade_in)) {
+    if (AnimationsExists(state->animations, state->def_anims.fade_in)) {
         DrawRectangle(0, 0, state->screen_size.Width, state->screen_size.Height,
                       (Color){0, 0, 0,
-                              255 * AnimationsLoad_(state->animations,
+                              255 * AnimationsLoad(state->animations,
                                                     state->def_anims.fade_in)});
     }
 
     EndDrawing();
+
+    AllocFrameEnd();
 }
 
 static void
@@ -613,11 +843,46 @@ WriteString(const char *str, FILE *fptr) {
     fwrite(str, sizeof(char), len + 1, fptr);
 }
 
-static void
-ReadString(char *str, FILE *fptr) {
+// Returns the length of the string WriteString wrote next, without reading
+// past it, or UINT32_MAX if the file ends first.
+static U32
+PeekStringLength(FILE *fptr) {
     U32 len;
-    fread(&len, sizeof(U32), 1, fptr);
-    fread(str, sizeof(char), len + 1, fptr);
+
+    if (fread(&len, sizeof(U32), 1, fptr) != 1) {
+        return UINT32_MAX;
+    }
+
+    fseek(fptr, -(long)sizeof(U32), SEEK_CUR);
+
+    return len;
+}
+
+// Reads a string written by WriteString into str, which holds size bytes. A
+// string that doesn't fit is skipped and read as empty.
+static B8
+ReadString(char *str, U32 size, FILE *fptr) {
+    U32 len;
+
+    str[0] = '\0';
+
+    if (fread(&len, sizeof(U32), 1, fptr) != 1) {
+        return false;
+    }
+
+    if (len >= size) {
+        fseek(fptr, (long)len + 1, SEEK_CUR);
+        return false;
+    }
+
+    if (fread(str, sizeof(char), len + 1, fptr) != len + 1) {
+        str[0] = '\0';
+        return false;
+    }
+
+    str[len] = '\0';
+
+    return true;
 }
 
 static void
@@ -636,13 +901,15 @@ Serialize() {
         U32 param_count = ParameterCount(state->parameters);
         fwrite(&param_count, sizeof(U32), 1, fptr);
 
-        Parameter *parameter;
-        U32        _ = 0;
-        while (ParameterIter(state->parameters, &_, &parameter)) {
-            WriteString(parameter->name, fptr);
-            fwrite(&parameter->value, sizeof(F32), 1, fptr);
-            fwrite(&parameter->min, sizeof(F32), 1, fptr);
-            fwrite(&parameter->max, sizeof(F32), 1, fptr);
+        for (ParameterHandle i = 0; i < param_count; ++i) {
+            F32 value = ParameterGetValue(state->parameters, i);
+            F32 min = ParameterMin(state->parameters, i);
+            F32 max = ParameterMax(state->parameters, i);
+
+            WriteString(ParameterName(state->parameters, i), fptr);
+            fwrite(&value, sizeof(F32), 1, fptr);
+            fwrite(&min, sizeof(F32), 1, fptr);
+            fwrite(&max, sizeof(F32), 1, fptr);
         }
 
         fclose(fptr);
@@ -657,35 +924,49 @@ Deserialize() {
         FILE *fptr;
         fptr = fopen(FSFormatDataDirectory("data.ly"), "rb");
         {
+            fseek(fptr, 0, SEEK_END);
+            long file_size = ftell(fptr);
+            fseek(fptr, 0, SEEK_SET);
+
             fread(&state->screen_size, sizeof(HMM_Vec2), 1, fptr);
             fread(&state->window_position, sizeof(HMM_Vec2), 1, fptr);
             fread(&state->master_volume, sizeof(F32), 1, fptr);
 
-            ReadString(state->music_fp, fptr);
+            ReadString(state->music_fp, sizeof(state->music_fp), fptr);
 
-            U32 param_count;
+            U32 param_count = 0;
             fread(&param_count, sizeof(U32), 1, fptr);
 
+            // Names can be any length, so they are read into scratch memory.
+            // A length past the end of the file means the file is damaged.
+            ArenaTemp scratch = ArenaBeginTemp(&state->transient);
+
             for (U32 i = 0; i < param_count; ++i) {
-                char buf[256];
-                F32  value, min, max;
+                U32 length = PeekStringLength(fptr);
 
-                ReadString(buf, fptr);
+                if ((U64)length >= (U64)(file_size - ftell(fptr))) {
+                    break;
+                }
 
-                char *name = ArenaPushString(&state->arena, buf);
+                char *name =
+                    ArenaPushArray(&state->transient, length + 1, char);
+                F32 value, min, max;
+
+                if (!ReadString(name, length + 1, fptr)) {
+                    break;
+                }
 
                 fread(&value, sizeof(F32), 1, fptr);
                 fread(&min, sizeof(F32), 1, fptr);
                 fread(&max, sizeof(F32), 1, fptr);
 
-                if (hashmap_get(state->parameters,
-                                &(Parameter){.name = name})) {
-                    ParameterSet(state->parameters, &(Parameter){.name = name,
-                                                                 .value = value,
-                                                                 .min = min,
-                                                                 .max = max});
-                }
+                // Only parameters the script still declares are restored.
+                ParameterSet(state->parameters,
+                             ParameterFind(state->parameters, name), value, min,
+                             max);
             }
+
+            ArenaEndTemp(scratch);
         }
         fclose(fptr);
 
@@ -695,28 +976,37 @@ Deserialize() {
     return false;
 }
 
+static F32
+GetDefParam(ParameterHandle handle) {
+    return ParameterGetValue(state->parameters, handle);
+}
+
+static void
+SetDefParam(ParameterHandle handle, F32 value) {
+    ParameterSetValue(state->parameters, handle, value);
+}
+
 static void
-RenderParameterSlider(const char *name,
-                      Rectangle   rect,
-                      const char *text_left,
-                      const char *text_right,
-                      F32         min,
-                      F32         max) {
-    F32 val = ParameterGetValue(state->parameters, name);
+RenderParameterSlider(ParameterHandle handle,
+                      Rectangle       rect,
+                      const char     *text_left,
+                      const char     *text_right,
+                      F32             min,
+                      F32             max) {
+    F32 val = ParameterGetValue(state->parameters, handle);
 
     GuiSlider(rect, text_left, text_right, &val, min, max);
 
-    ParameterSetValue(state->parameters, name, val);
+    ParameterSetValue(state->parameters, handle, val);
 }
 
 static void
 RenderUI() {
-    F32        padding = 20;
-    F32        button_height = 25;
-    F32        font_size = 20;
-    F32        toggle_width = 25;
-    Parameter *parameter;
-    U32        _, i = 0;
+    F32 padding = 20;
+    F32 button_height = 25;
+    F32 font_size = 20;
+    F32 toggle_width = 25;
+    U32 i = 0;
 
     UIToggleMenuData data =
         UIMeasureToggleMenu(state->parameters, state->procedures, state->font,
@@ -752,46 +1042,38 @@ RenderUI() {
         }
 
         if (max_param_width > 50) {
-            parameter = 0;
-            _ = 0;
-            i = 0;
-            while (ParameterIter(state->parameters, &_, &parameter)) {
-                if (!parameter) {
-                    continue;
-                }
+            Parameters *params = state->parameters;
 
+            for (i = 0; i < ParameterCount(params); ++i) {
                 RenderParameterSlider(
-                    parameter->name,
+                    i,
                     (Rectangle){left,
                                 i * (button_height + padding / 2) + padding,
                                 param_width > max_param_width ? max_param_width
                                                               : param_width,
                                 button_height},
-                    parameter->name, TextFormat("[%.2f]", parameter->value),
-                    parameter->min, parameter->max);
-                ++i;
+                    ParameterName(params, i),
+                    TextFormat("[%.2f]", ParameterGetValue(params, i)),
+                    ParameterMin(params, i), ParameterMax(params, i));
             }
         }
 
         // Render procedure buttons
-        Procedure *proc = 0;
-        _ = 0;
-        i = 0;
-        while (ProcedureIter(state->procedures, &_, &proc)) {
-            if (!proc) {
-                continue;
-            }
+        Procedures *procs = state->procedures;
 
-            if (GuiToggle(
-                    (Rectangle){state->screen_size.Width -
-                                    data.proc_button_width - padding,
-                                i * (button_height + padding / 2) + padding,
-                                data.proc_button_width - padding,
-                                button_height},
-                    TextFormat("%s", proc->name), &proc->active)) {
-                ProcedureToggle(state->procedures, proc->name);
+        for (i = 0; i < ProcedureCount(procs); ++i) {
+            B8 active = ProcedureActive(procs, i);
+
+            GuiToggle((Rectangle){state->screen_size.Width -
+                                      data.proc_button_width - padding,
+                                  i * (button_height + padding / 2) + padding,
+                                  data.proc_button_width - padding,
+                                  button_height},
+                      ProcedureName(procs, i), &active);
+
+            if (active != ProcedureActive(procs, i)) {
+                ProcedureSetActive(procs, i, active);
             }
-            ++i;
         }
 
         if (GuiButton(
@@ -826,14 +1108,20 @@ static void
 Render() {
     ApiPreRender(state->api_data, state);
 
-    _ProcedureCall(state->def_procs.circle_frequencies);
-    _ProcedureCall(state->def_procs.normal_frequencies);
+    ProceduresRender(state->procedures);
 
     ApiRender(state->api_data, state);
 }
 
 static void
 BeginRecording() {
+    if (atomic_load(&state->record_data.ending)) {
+        StateAddPopUp("Still saving the last recording.");
+        return;
+    }
+
+    AllocSettle();
+
     state->condition = StateCondition_RECORDING;
 
     if (!FSCanRunCMD("ffmpegs")) {
@@ -842,63 +1130,103 @@ BeginRecording() {
         return;
     }
 
+    state->record_data.live = state->loopback;
+
+    if (!state->record_data.live &&
+        !PcmCacheReady(state->pcm_cache, state->music_fp)) {
+        state->condition = StateCondition_NORMAL;
+        StateAddPopUp(
+            TextFormat("Still preparing %s for recording (%d%%)",
+                       GetFileName(state->music_fp),
+                       (I32)(PcmCacheProgress(state->pcm_cache) * 100)));
+        return;
+    }
+
     HMM_Vec2 render_size = HMM_V2(state->renderer_data->screen.texture.width,
                                   state->renderer_data->screen.texture.height);
 
-    state->ffmpeg = FFMPEGStart(render_size, RENDER_FPS, state->music_fp);
+    state->ffmpeg = FFMPEGStart(
+        render_size, RENDER_FPS,
+        state->record_data.live ? NULL : state->music_fp,
+        state->record_data.live ? RECORD_LIVE_VIDEO : RECORD_OUTPUT);
 
     if (state->ffmpeg < 0) {
         state->condition = StateCondition_NORMAL;
         return;
     }
 
-    memset(state->samples, 0, sizeof(F32) * SAMPLE_COUNT);
-    memset(state->frequencies, 0, sizeof(F32) * state->frequency_count);
+    if (state->record_data.live) {
+        if (!CaptureBegin(state->capture, RECORD_LIVE_AUDIO,
+                          LoopbackSampleRate(state->loopback_data),
+                          LoopbackChannels(state->loopback_data))) {
+            FFMPEGEnd(state->ffmpeg);
+            state->condition = StateCondition_NORMAL;
+            StateAddPopUp("Couldn't open " RECORD_LIVE_AUDIO " to record to.");
+            return;
+        }
+    } else {
+        // The ring is only reset when nothing else is writing to it.
+        PlayerPause(state->player);
 
-    state->record_start = GetTime();
+        SampleRingReset(&state->ring, state->analysis_rate);
+        HistoryReset(state->history);
+        memset(state->samples, 0, sizeof(F32) * SAMPLE_COUNT);
+        memset(state->frequencies, 0, sizeof(F32) * state->frequency_count);
+    }
 
-    state->record_data.wave = LoadWave(state->music_fp);
-    state->record_data.wave_samples = LoadWaveSamples(state->record_data.wave);
-    state->record_data.wave_cursor = 0;
+    state->record_start = GetTime();
 
-    PauseMusicStream(state->music);
+    state->record_data.cursor = 0;
+    state->record_data.frames = 0;
 
     state->def_anims.recording =
         AnimationsAdd(state->animations, "recording", &(F32){0.4f},
-                      FadeAnimationUpdate, &state->arena);
+                      FadeAnimationUpdate);
 }
 
 static void
 EndRecording() {
     FFMPEGEnd(state->ffmpeg);
 
-    UnloadWave(state->record_data.wave);
-    UnloadWaveSamples(state->record_data.wave_samples);
+    if (!state->record_data.live) {
+        return;
+    }
+
+    if (CaptureEnd(state->capture) &&
+        FFMPEGMux(RECORD_LIVE_VIDEO, RECORD_LIVE_AUDIO, RECORD_OUTPUT)) {
+        remove(RECORD_LIVE_VIDEO);
+        remove(RECORD_LIVE_AUDIO);
+    } else {
+        printf("Failed to mux the live recording; kept %s and %s.\n",
+               RECORD_LIVE_VIDEO, RECORD_LIVE_AUDIO);
+    }
 }
 
 static void
 UpdateRecording() {
-    U32 chunk_size = state->record_data.wave.sampleRate / RENDER_FPS;
-    F32(*frames)
-    [state->record_data.wave.channels] =
-        (void *)state->record_data.wave_samples;
-    for (U32 i = 0; i < chunk_size; ++i) {
-        if (state->record_data.wave_cursor <
-            state->record_data.wave.frameCount) {
-            StatePushFrame(frames[state->record_data.wave_cursor][0],
-                           state->samples, SAMPLE_COUNT);
-        } else {
-            StatePushFrame(0, state->samples, SAMPLE_COUNT);
-        }
-        state->record_data.wave_cursor++;
-    }
+    // The cache is already at the analysis rate, so no resampling here.
+    U32 chunk_size = state->analysis_rate / RENDER_FPS;
+    F32 *chunk = ArenaPushArray(&state->transient, chunk_size, F32);
 
-    SignalsProcessSamples(
-        LOG_MUL, START_FREQ, state->samples, SAMPLE_COUNT, state->frequencies,
-        &state->frequency_count, 1 / (F32)RENDER_FPS,
-        (U32)_ParameterGetValue(state->def_params.smoothing), state->filter,
-        state->filter_count, _ParameterGetValue(state->def_params.velocity),
-        state->zero_frequencies);
+    PcmCacheRead(state->pcm_cache, state->record_data.cursor, chunk,
+                 chunk_size);
+    SampleRingWrite(&state->ring, chunk, chunk_size, GetTime());
+
+    state->record_data.cursor += chunk_size;
+
+    // Offline, so the newest sample is the one being rendered.
+    ReadAnalysisWindow(false);
+
+    UpdateFrequencies(state->record_data.cursor, 1 / (F32)RENDER_FPS);
+}
+
+// Input arrives in real time, so the frame shows the newest audio, the same
+// audio capture is writing out.
+static void
+UpdateLiveRecording() {
+    ReadAnalysisWindow(false);
+
+    UpdateFrequencies(-1, state->dt);
 }
 
 static void
@@ -906,8 +1234,8 @@ SetFrequencyCount() {
     U32 freq_count;
     SignalsProcessSamples(
         LOG_MUL, START_FREQ, 0, SAMPLE_COUNT, NULL, &freq_count, 0,
-        (U32)_ParameterGetValue(state->def_params.smoothing), state->filter,
-        state->filter_count, _ParameterGetValue(state->def_params.velocity),
+        (U32)GetDefParam(state->def_params.smoothing), state->filter,
+        state->filter_count, GetDefParam(state->def_params.velocity),
         state->zero_frequencies);
 
     if (freq_count != state->frequency_count) {
@@ -918,6 +1246,9 @@ SetFrequencyCount() {
     }
 }
 
+// Replaces the playlist with the dropped files and directories, and queues
+// the first track on the loader. The current track keeps playing until the
+// new one is ready.
 static B8
 GetDroppedFiles() {
     B8 ret = false;
@@ -925,21 +1256,19 @@ GetDroppedFiles() {
     FilePathList dropped_files = LoadDroppedFiles();
 
     if (dropped_files.count > 0) {
-        if (IsMusicReady(state->music)) {
-            DetachAudioStreamProcessor(state->music.stream, FrameCallback);
-            StopMusicStream(state->music);
-            UnloadMusicStream(state->music);
-        }
+        PlaylistClear(state->playlist);
 
-        state->music = LoadMusicStream(dropped_files.paths[0]);
-        strcpy(state->music_fp, dropped_files.paths[0]);
+        for (U32 i = 0; i < dropped_files.count; ++i) {
+            PlaylistAdd(state->playlist, dropped_files.paths[i]);
+        }
 
-        if (IsMusicReady(state->music)) {
-            PlayMusicStream(state->music);
-            AttachAudioStreamProcessor(state->music.stream, FrameCallback);
+        if (state->playlist->count > 0) {
+            TrackLoaderCancel(state->prefetch);
+            TrackLoaderRequest(state->loader,
+                               PlaylistCurrent(state->playlist));
             ret = true;
-
-            SetWindowTitle(TextFormat("Apollo - %s", dropped_files.paths[0]));
+        } else {
+            StateAddPopUp("No playable files were dropped");
         }
     }
 
@@ -948,10 +1277,120 @@ GetDroppedFiles() {
     return ret;
 }
 
+static void
+SetCurrentTrack() {
+    AllocSettle();
+
+    strcpy(state->music_fp, PlayerPath(state->player));
+    SetWindowTitle(TextFormat("Apollo - %s", state->music_fp));
+
+    PcmCacheRequest(state->pcm_cache, state->music_fp, state->analysis_rate);
+}
+
+// Drops path from the playlist after it failed to load, if it is the entry
+// at index.
+static void
+RemoveFailedTrack(const char *path, U32 index) {
+    StateAddPopUp(TextFormat("Couldn't load %s", GetFileName(path)));
+
+    if (index < state->playlist->count &&
+        strcmp(state->playlist->paths[index], path) == 0) {
+        PlaylistRemove(state->playlist, index);
+    }
+}
+
+// Follows the player onto the next track and keeps the playlist entry after
+// it opened and queued, so the player can run straight into it.
+static void
+UpdatePlayback() {
+    if (PlayerUpdate(state->player)) {
+        PlaylistAdvance(state->playlist);
+        SetCurrentTrack();
+    }
+
+    PcmCacheUpdate(state->pcm_cache);
+
+    if (PcmCacheReady(state->pcm_cache, state->music_fp)) {
+        SpectrogramRequest(state->spectrogram, state->pcm_cache);
+    }
+
+    SpectrogramUpdate(state->spectrogram);
+
+    TrackLoaderStatus status = TrackLoaderUpdate(state->prefetch);
+
+    if (status == TrackLoaderStatus_READY ||
+        status == TrackLoaderStatus_FAILED) {
+        Track *track = TrackLoaderTake(state->prefetch);
+
+        if (track) {
+            PlayerQueue(state->player, track);
+        } else {
+            RemoveFailedTrack(state->prefetch->path,
+                              PlaylistNextIndex(state->playlist));
+        }
+
+        return;
+    }
+
+    if (state->playlist->count > 0 && !PlayerHasNext(state->player) &&
+        !TrackLoaderBusy(state->prefetch) && !TrackLoaderBusy(state->loader)) {
+        TrackLoaderRequest(
+            state->prefetch,
+            state->playlist->paths[PlaylistNextIndex(state->playlist)]);
+    }
+}
+
+// Swaps in a track once the loader has opened it. Runs at the top of the
+// frame, so the audio callback never sees a half-replaced stream.
+static void
+UpdateTrackLoader() {
+    TrackLoaderStatus status = TrackLoaderUpdate(state->loader);
+
+    if (status != TrackLoaderStatus_READY &&
+        status != TrackLoaderStatus_FAILED) {
+        return;
+    }
+
+    Track *track = TrackLoaderTake(state->loader);
+
+    if (!track) {
+        RemoveFailedTrack(state->loader->path, state->playlist->index);
+
+        if (state->playlist->count > 0) {
+            TrackLoaderRequest(state->loader,
+                               PlaylistCurrent(state->playlist));
+        }
+
+        return;
+    }
+
+    PlayerLoad(state->player, track);
+    SetCurrentTrack();
+
+    ResetMusicResampler();
+
+    state->condition = StateCondition_NORMAL;
+}
+
+// Resamples channel 0 of interleaved frames and appends the result to ring.
+// Input is chunked so every block fits on the stack.
 void
-StatePushFrame(F32 val, F32 *samples, U32 sample_count) {
-    memmove(samples, samples + 1, (sample_count - 1) * sizeof(F32));
-    samples[sample_count - 1] = val;
+StatePushResampled(Resampler  *resampler,
+                   F32        *frames,
+                   U32         channels,
+                   U32         frame_count,
+                   SampleRing *ring) {
+    F32 resampled[RESAMPLER_BLOCK];
+    U32 chunk = ResamplerMaxInput(resampler, RESAMPLER_BLOCK);
+    F64 time = GetTime();
+
+    for (U32 i = 0; i < frame_count; i += chunk) {
+        U32 count =
+            ResamplerProcess(resampler, frames + i * channels, channels,
+                             MinU32(chunk, frame_count - i), resampled);
+
+        SampleRingWrite(ring, resampled, count, time);
+    }
 }
 
 B8
@@ -959,13 +1398,137 @@ StateShouldClose() {
     return state->should_close;
 }
 
+// Marks resampler_middle as holding a resampler the callback hasn't seen.
+#define RESAMPLER_FRESH (1u << 31)
+
+// The audio thread may be resampling right now, so the new filter is built
+// in the back resampler and handed over for FrameCallback to pick up.
+static void
+ResetMusicResampler() {
+    ResamplerInitialise(&state->resamplers[state->resampler_back],
+                        state->player->sample_rate, state->analysis_rate);
+
+    state->resampler_back =
+        atomic_exchange(&state->resampler_middle,
+                        state->resampler_back | RESAMPLER_FRESH) &
+        ~RESAMPLER_FRESH;
+}
+
+// Fills samples with the analysis window. With compensate set, the window
+// ends at the frame currently leaving the speakers instead of the newest one
+// in the ring.
+static void
+ReadAnalysisWindow(B8 compensate) {
+    U64 end = SampleRingWritten(&state->ring);
+
+    if (compensate) {
+        end = SampleRingPlayhead(&state->ring, GetTime(), AnalysisLatency());
+    }
+
+    SampleRingRead(&state->ring, end, state->samples, SAMPLE_COUNT);
+
+    state->analysis_end = end;
+
+    UpdateHistory();
+}
+
+// Copies whatever has reached ring since the last frame into history.
+static void
+UpdateHistory() {
+    U64 written = SampleRingWritten(&state->ring);
+    U64 from = MaxU64(HistoryWritten(state->history),
+                      written > SAMPLE_RING_CAPACITY
+                          ? written - SAMPLE_RING_CAPACITY
+                          : 0);
+
+    F32 block[HISTORY_CHUNK_FRAMES];
+
+    // Anything the ring has already dropped is lost; history skips over it.
+    if (from > HistoryWritten(state->history)) {
+        memset(block, 0, sizeof(block));
+
+        while (HistoryWritten(state->history) < from) {
+            HistoryWrite(state->history, block,
+                         MinU64(HISTORY_CHUNK_FRAMES,
+                                from - HistoryWritten(state->history)));
+        }
+    }
+
+    while (from < written) {
+        U32 count = MinU64(HISTORY_CHUNK_FRAMES, written - from);
+
+        SampleRingRead(&state->ring, from + count, block, count);
+        HistoryWrite(state->history, block, count);
+
+        from += count;
+    }
+}
+
+// Seconds between a frame reaching the audio device and being heard.
+static F64
+AnalysisLatency() {
+    F64 latency = GetDefParam(state->def_params.av_offset) / 1000.0;
+
+    if (!state->loopback) {
+        latency += state->output_latency;
+    }
+
+    return latency;
+}
+
+// Advances frequencies by one frame. The spectrum comes from the cached
+// spectrogram when the current track has one and position (the end of the
+// analysis window, in analysis samples into the track) is known; otherwise
+// it is computed from samples.
+static void
+UpdateFrequencies(I64 position, F32 dt) {
+    U32 spectrum_count =
+        SignalsSpectrumCount(LOG_MUL, START_FREQ, SAMPLE_COUNT);
+    F32 *spectrum = ArenaPushArray(&state->transient, spectrum_count, F32);
+
+    if (!SpectrogramReady(state->spectrogram, state->music_fp) ||
+        !SpectrogramLookup(state->spectrogram, position, spectrum)) {
+        SignalsSpectrum(LOG_MUL, START_FREQ, state->samples, SAMPLE_COUNT,
+                        spectrum);
+    }
+
+    SignalsApplySpectrum(
+        spectrum, spectrum_count, state->frequencies, &state->frequency_count,
+        dt, (U32)GetDefParam(state->def_params.smoothing), state->filter,
+        state->filter_count, GetDefParam(state->def_params.velocity),
+        state->zero_frequencies);
+
+    StemsUpdate(state->stems, position, dt,
+                (U32)GetDefParam(state->def_params.smoothing), state->filter,
+                state->filter_count, GetDefParam(state->def_params.velocity));
+}
+
 static void
 FrameCallback(void *buffer_data, U32 n) {
-    F32(*frame_data)[state->music.stream.channels] = buffer_data;
+    RealtimePromoteAudio(state->realtime);
+
+    // Processors run when the device pulls a period, and the device keeps a
+    // few periods queued, so the block just handed to us is heard roughly
+    // AUDIO_DEVICE_PERIODS blocks from now.
+    F32 block = (F32)n / state->player->sample_rate;
+    state->output_latency +=
+        (block * AUDIO_DEVICE_PERIODS - state->output_latency) * 0.1f;
+
+    // A new resampler starts with empty history, so swapping is all a reset
+    // costs here.
+    if (atomic_load(&state->resampler_middle) & RESAMPLER_FRESH) {
+        state->resampler_front =
+            atomic_exchange(&state->resampler_middle, state->resampler_front) &
+            ~RESAMPLER_FRESH;
+        state->resampler_ready = true;
+    }
 
-    for (U32 i = 0; i < n; ++i) {
-        StatePushFrame(frame_data[i][0], state->samples, SAMPLE_COUNT);
+    if (!state->resampler_ready) {
+        return;
     }
+
+    StatePushResampled(&state->resamplers[state->resampler_front],
+                       buffer_data, PLAYER_CHANNELS, n, &state->ring);
 }
 
 static void
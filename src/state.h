@@ -1,19 +1,32 @@
 #pragma once
 
 #include <complex.h>
+#include <stdatomic.h>
 
 #include "animation.h"
 #include "api.h"
 #include "arena.h"
+#include "capture.h"
 #include "defines.h"
+#include "free_list.h"
 #include "handmademath.h"
 #include "hashmap.h"
+#include "history.h"
+#include "loader.h"
 #include "loopback.h"
 #include "parameter.h"
+#include "pcm_cache.h"
+#include "player.h"
+#include "playlist.h"
 #include "procedures.h"
 #include "raylib.h"
+#include "realtime.h"
 #include "renderer.h"
+#include "resampler.h"
+#include "sample_ring.h"
 #include "server.h"
+#include "spectrogram.h"
+#include "stems.h"
 
 typedef struct State State;
 
@@ -27,14 +40,12 @@ typedef enum StateCondition {
 
 #define MAX_PARAM_COUNT 100
 
-#define FREQUENCY_COUNT 2048
-
 typedef struct StateMemory {
     void *permanent_storage;
-    U32   permanent_storage_size;
+    U64   permanent_storage_size;
 
     void *transient_storage;
-    U32   transient_storage_size;
+    U64   transient_storage_size;
 } StateMemory;
 
 #define FONT_SIZES_PER_FONT 12
@@ -56,76 +67,135 @@ typedef struct StatePopUp {
     char text[512];
 } StatePopUp;
 
-#define MAX_ANIMATION_COUNT 512
 #define MAX_POP_UPS 10
+// Laid out by who touches what. The hot section is everything a frame reads
+// on the main thread, packed together. Fields the audio threads write start
+// on their own cache lines, and everything else is kept out of the way at the
+// end.
 typedef struct State {
-    MemoryArena arena;
+    // Hot: read or written by the main thread every frame.
+    StateCondition condition;
+    F32            dt;
+    F32            master_volume;
+
+    B8 render_ui;
+    B8 ui;
+    B8 loopback;
+    B8 should_close;
+    B8 zero_frequencies;
+
+    U32 analysis_rate;
+
+    // The frame samples ends at, so scripts can line it up with history.
+    U64 analysis_end;
+
+    U32  frequency_count;
+    F32 *filter;
+    U32  filter_count;
+
+    // Reset at the top of every update. Anything pushed here lives until
+    // the end of the frame at most.
+    MemoryArena transient;
+
+    Parameters *parameters;
+    Animations *animations;
+    Procedures *procedures;
 
     RendererData *renderer_data;
     ApiData      *api_data;
+    Player       *player;
+    PcmCache     *pcm_cache;
+    Spectrogram  *spectrogram;
+    Stems        *stems;
+    Realtime     *realtime;
+
+    // Longer, compressed record of what passed through ring.
+    History *history;
+
+    F32 frequencies[FREQUENCY_COUNT];
+
+    // samples is the analysis window for the current frame, read from ring so
+    // that it ends at the audible playhead rather than at the newest decoded
+    // sample.
+    F32 samples[SAMPLE_COUNT];
+
+    // Audio thread: written on every playback callback, only sampled by the
+    // main thread. resamplers convert the player stream to analysis_rate
+    // before it reaches ring.
+    _Alignas(CACHE_LINE_SIZE) F32 output_latency;
+
+    // Triple buffered, so building a filter never happens on the audio
+    // thread. The callback reads resamplers[resampler_front] and the main
+    // thread builds new ones in resamplers[resampler_back]. They trade
+    // through resampler_middle, which is flagged when it holds a new one.
+    // resampler_ready is set once the callback has had its first.
+    Resampler   resamplers[3];
+    _Atomic U32 resampler_middle;
+    U32         resampler_front;
+    U32         resampler_back;
+    B8          resampler_ready;
+
+    // Shared: everything the audio threads deliver lands in ring. They are
+    // its only writers; the main thread only reads.
+    _Alignas(CACHE_LINE_SIZE) SampleRing ring;
+
+    // Cold: set up once, or only used on rare events.
+    _Alignas(CACHE_LINE_SIZE) MemoryArena arena;
+
     LoopbackData *loopback_data;
     ServerData   *server_data;
+    TrackLoader  *loader;
+    TrackLoader  *prefetch;
+    Playlist     *playlist;
+    Capture      *capture;
 
     Thread *recording_thread;
 
-    Music music;
-    char  music_fp[256];
+    char music_fp[256];
 
     StateFont font;
 
-    F32 samples[SAMPLE_COUNT];
-
-    F32 frequencies[FREQUENCY_COUNT];
-    U32 frequency_count;
-
-    F32 master_volume;
-    F32 dt;
     F32 record_start;
-
     I32 ffmpeg;
 
+    // Recording reads the track from pcm_cache, one video frame at a time.
+    // In loopback the input is recorded live through capture instead.
     struct {
-        Wave wave;
-        F32 *wave_samples;
-        U32  wave_cursor;
+        U64 cursor;
+        B8  live;
+
+        // Video frames sent so far. Live recordings render faster than
+        // RENDER_FPS, so frames are dropped or repeated to keep pace.
+        U64 frames;
+
+        // Set while recording_thread muxes the last live recording. Its files
+        // are reused, so no new recording starts until it clears. joinable is
+        // set from ThreadCreate until the thread is joined.
+        _Atomic I32 ending;
+        B8          joinable;
     } record_data;
 
     struct {
-        _Parameter smoothing;
-        _Parameter velocity;
-        _Parameter master_volume;
+        ParameterHandle smoothing;
+        ParameterHandle velocity;
+        ParameterHandle master_volume;
+        ParameterHandle av_offset;
     } def_params;
 
     struct {
-        _Procedure circle_frequencies;
-        _Procedure normal_frequencies;
+        ProcedureHandle circle_frequencies;
+        ProcedureHandle normal_frequencies;
     } def_procs;
 
     struct {
-        _Animation *exiting;
-        _Animation *recording;
-        _Animation *end_recording;
-        _Animation *fade_in;
-        _Animation *pop_up;
-        _Animation *pop_up_exit;
+        AnimationHandle exiting;
+        AnimationHandle recording;
+        AnimationHandle end_recording;
+        AnimationHandle fade_in;
+        AnimationHandle pop_up;
+        AnimationHandle pop_up_exit;
     } def_anims;
 
-    F32 *filter;
-    U32  filter_count;
-
-    StateCondition condition;
-
-    HM_Hashmap *parameters;
-    HM_Hashmap *animations;
-    HM_Hashmap *procedures;
-
-    B8 render_ui;
-    B8 ui;
-    B8 loopback;
-    B8 should_close;
-
-    B8 zero_frequencies;
-
     HMM_Vec2 screen_size;
     HMM_Vec2 window_position;
 
@@ -142,7 +212,11 @@ StateRender();
 void
 StateDestroy();
 void
-StatePushFrame(F32 val, F32 *samples, U32 sample_count);
+StatePushResampled(Resampler  *resampler,
+                   F32        *frames,
+                   U32         channels,
+                   U32         frame_count,
+                   SampleRing *ring);
 
 B8
 StateShouldClose();
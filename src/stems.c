@@ -0,0 +1,138 @@
+#include "stems.h"
+
+#include <string.h>
+
+#include "arena.h"
+#include "defines.h"
+#include "pcm_cache.h"
+#include "pool.h"
+#include "signals.h"
+
+// Pool job. Reads the window ending at position from the stem's cache and
+// moves its frequencies on by one frame.
+static void
+AnalyseStem(void *user_data, U32 index) {
+    Stems *stems = user_data;
+    Stem  *stem = &stems->stems[index];
+
+    if (stems->position < 0 || !PcmCacheReady(stem->cache, stem->path)) {
+        memset(stem->samples, 0, sizeof(stem->samples));
+    } else {
+        PcmCacheRead(stem->cache, stems->position - SAMPLE_COUNT,
+                     stem->samples, SAMPLE_COUNT);
+    }
+
+    U32 spectrum_count =
+        SignalsSpectrumCount(LOG_MUL, START_FREQ, SAMPLE_COUNT);
+    F32 spectrum[spectrum_count];
+
+    SignalsSpectrum(LOG_MUL, START_FREQ, stem->samples, SAMPLE_COUNT,
+                    spectrum);
+    SignalsApplySpectrum(spectrum, spectrum_count, stem->frequencies,
+                         &stem->frequency_count, stems->dt, stems->smoothing,
+                         stems->filter, stems->filter_count, stems->velocity,
+                         false);
+}
+
+void
+StemsInitialise(Stems *stems, MemoryArena *arena) {
+    memset(stems, 0, sizeof(Stems));
+
+    for (U32 i = 0; i < STEMS_MAX; ++i) {
+        stems->stems[i].cache = ArenaPushStruct(arena, PcmCache);
+        PcmCacheInitialise(stems->stems[i].cache, arena);
+    }
+
+    PoolInitialise(&stems->pool, 0, arena);
+}
+
+void
+StemsDestroy(Stems *stems) {
+    PoolDestroy(&stems->pool);
+
+    for (U32 i = 0; i < STEMS_MAX; ++i) {
+        PcmCacheDestroy(stems->stems[i].cache);
+    }
+}
+
+// Adds a stem, or points an existing one with the same name at a new file.
+// Returns false once STEMS_MAX stems are loaded.
+B8
+StemsLoad(Stems *stems, const char *name, const char *path) {
+    Stem *stem = StemsFind(stems, name);
+
+    if (!stem) {
+        if (stems->count == STEMS_MAX) {
+            return false;
+        }
+
+        stem = &stems->stems[stems->count++];
+
+        strncpy(stem->name, name, sizeof(stem->name) - 1);
+        stem->name[sizeof(stem->name) - 1] = '\0';
+
+        memset(stem->frequencies, 0, sizeof(stem->frequencies));
+    }
+
+    strncpy(stem->path, path, sizeof(stem->path) - 1);
+    stem->path[sizeof(stem->path) - 1] = '\0';
+
+    // Decoding starts on the next update, as scripts can load stems before
+    // the analysis rate is known.
+    stem->requested = false;
+
+    return true;
+}
+
+// Forgets every stem. Their caches stay on disk.
+void
+StemsClear(Stems *stems) {
+    stems->count = 0;
+}
+
+Stem *
+StemsFind(Stems *stems, const char *name) {
+    for (U32 i = 0; i < stems->count; ++i) {
+        if (strcmp(stems->stems[i].name, name) == 0) {
+            return &stems->stems[i];
+        }
+    }
+
+    return NULL;
+}
+
+// Call once per frame with the analysis position of the main track, in
+// samples at sample_rate, or -1 when there is none. Stems still being
+// decoded analyse as silence.
+void
+StemsUpdate(Stems *stems,
+            I64    position,
+            F32    dt,
+            U32    smoothing,
+            F32   *filter,
+            U32    filter_count,
+            F32    velocity) {
+    for (U32 i = 0; i < STEMS_MAX; ++i) {
+        Stem *stem = &stems->stems[i];
+
+        PcmCacheUpdate(stem->cache);
+
+        if (i < stems->count && !stem->requested) {
+            PcmCacheRequest(stem->cache, stem->path, stems->sample_rate);
+            stem->requested = true;
+        }
+    }
+
+    if (stems->count == 0) {
+        return;
+    }
+
+    stems->position = position;
+    stems->dt = dt;
+    stems->smoothing = smoothing;
+    stems->filter = filter;
+    stems->filter_count = filter_count;
+    stems->velocity = velocity;
+
+    PoolRun(&stems->pool, stems->count, AnalyseStem, stems);
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "arena.h"
+#include "defines.h"
+#include "pcm_cache.h"
+#include "pool.h"
+
+#define STEMS_MAX 8
+
+// One source of a multitrack session, e.g. drums or vocals, playing in sync
+// with the main track.
+typedef struct Stem {
+    char      name[32];
+    char      path[256];
+    PcmCache *cache;
+    B8        requested;
+
+    F32 samples[SAMPLE_COUNT];
+    F32 frequencies[FREQUENCY_COUNT];
+    U32 frequency_count;
+} Stem;
+
+// Stems are analysed every frame exactly like the main track, one pool job
+// per stem, so the frame costs about as much as the slowest stem rather than
+// all of them. The pool is separate from the spectrogram's so a background
+// build never holds up a frame.
+typedef struct Stems {
+    Pool pool;
+
+    Stem stems[STEMS_MAX];
+    U32  count;
+
+    // Rate stems are decoded at. Set before the first update.
+    U32 sample_rate;
+
+    // Inputs to the current batch.
+    I64  position;
+    F32  dt;
+    U32  smoothing;
+    F32  velocity;
+    F32 *filter;
+    U32  filter_count;
+} Stems;
+
+void
+StemsInitialise(Stems *stems, MemoryArena *arena);
+void
+StemsDestroy(Stems *stems);
+B8
+StemsLoad(Stems *stems, const char *name, const char *path);
+void
+StemsClear(Stems *stems);
+Stem *
+StemsFind(Stems *stems, const char *name);
+void
+StemsUpdate(Stems *stems,
+            I64    position,
+            F32    dt,
+            U32    smoothing,
+            F32   *filter,
+            U32    filter_count,
+            F32    velocity);
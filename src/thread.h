@@ -6,3 +6,7 @@ typedef struct Thread Thread;
 Thread *ThreadAlloc(MemoryArena *arena);
 void    ThreadCreate(Thread *thread, void *(*thread_func)(void *), void *data);
 void    ThreadJoin(Thread *thread);
+void    ThreadSleep(F64 seconds);
+U32     ThreadCoreCount();
+B8      ThreadSetRealtime(Thread *thread, U32 priority, B8 round_robin);
+B8      ThreadSetAffinity(Thread *thread, U32 core);
@@ -1,7 +1,14 @@
+// For pthread_setaffinity_np.
+#define _GNU_SOURCE
+
 #include "arena.h"
+#include "lmath.h"
 #include "thread.h"
 
 #include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
 
 typedef struct Thread {
     pthread_t thread;
@@ -12,12 +19,70 @@ ThreadAlloc(MemoryArena *arena) {
     return ArenaPushStruct(arena, Thread);
 }
 
+// Analysis runs on worker threads and keeps FFT buffers on the stack, which
+// is more than some platforms give secondary threads by default.
+#define THREAD_STACK_SIZE (8 * 1024 * 1024)
+
 void
 ThreadCreate(Thread *thread, void *(*thread_func)(void *), void *data) {
-    pthread_create(&thread->thread, NULL, thread_func, data);
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstacksize(&attr, THREAD_STACK_SIZE);
+
+    pthread_create(&thread->thread, &attr, thread_func, data);
+
+    pthread_attr_destroy(&attr);
 }
 
 void
 ThreadJoin(Thread *thread) {
     pthread_join(thread->thread, NULL);
 }
+
+void
+ThreadSleep(F64 seconds) {
+    struct timespec ts = {.tv_sec = (time_t)seconds,
+                          .tv_nsec = (seconds - (time_t)seconds) * 1e9};
+
+    nanosleep(&ts, NULL);
+}
+
+U32
+ThreadCoreCount() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+
+    return count > 0 ? count : 1;
+}
+
+// Moves thread, or the calling thread if it is NULL, to SCHED_FIFO (or
+// SCHED_RR) at priority. Fails without CAP_SYS_NICE or an rtprio limit.
+B8
+ThreadSetRealtime(Thread *thread, U32 priority, B8 round_robin) {
+    pthread_t handle = thread ? thread->thread : pthread_self();
+    I32       policy = round_robin ? SCHED_RR : SCHED_FIFO;
+
+    struct sched_param param = {
+        .sched_priority =
+            ClampI32(priority, sched_get_priority_min(policy),
+                     sched_get_priority_max(policy)),
+    };
+
+    return pthread_setschedparam(handle, policy, &param) == 0;
+}
+
+// Pins thread, or the calling thread if it is NULL, to core. Only Linux can
+// pin threads; elsewhere this always fails.
+B8
+ThreadSetAffinity(Thread *thread, U32 core) {
+#if defined(__linux__)
+    pthread_t handle = thread ? thread->thread : pthread_self();
+    cpu_set_t set;
+
+    CPU_ZERO(&set);
+    CPU_SET(core % ThreadCoreCount(), &set);
+
+    return pthread_setaffinity_np(handle, sizeof(set), &set) == 0;
+#else
+    return false;
+#endif
+}
@@ -35,8 +35,10 @@ ThreadCreate(Thread *thread, ThreadFunc thread_func, void *data) {
     thread_data->func = thread_func;
     thread_data->data = data;
 
+    // Analysis runs on worker threads and keeps FFT buffers on the stack.
     thread->handle =
-        CreateThread(NULL, 0, ThreadFuncWrapper, thread_data, 0, NULL);
+        CreateThread(NULL, 8 * 1024 * 1024, ThreadFuncWrapper, thread_data,
+                     STACK_SIZE_PARAM_IS_A_RESERVATION, NULL);
 }
 
 void
@@ -45,3 +47,36 @@ ThreadJoin(Thread *thread) {
         WaitForSingleObject(thread->handle, INFINITE);
     }
 }
+
+void
+ThreadSleep(F64 seconds) {
+    Sleep((DWORD)(seconds * 1000));
+}
+
+U32
+ThreadCoreCount() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+
+    return info.dwNumberOfProcessors;
+}
+
+// Windows has no realtime policies for ordinary processes, so the closest is
+// the top of the normal range. priority is ignored.
+B8
+ThreadSetRealtime(Thread *thread, U32 priority, B8 round_robin) {
+    HANDLE handle = thread ? thread->handle : GetCurrentThread();
+
+    return SetThreadPriority(handle, round_robin
+                                         ? THREAD_PRIORITY_HIGHEST
+                                         : THREAD_PRIORITY_TIME_CRITICAL);
+}
+
+B8
+ThreadSetAffinity(Thread *thread, U32 core) {
+    HANDLE handle = thread ? thread->handle : GetCurrentThread();
+
+    return SetThreadAffinityMask(handle,
+                                 (DWORD_PTR)1 << (core % ThreadCoreCount())) !=
+           0;
+}
@@ -0,0 +1,57 @@
+#include "track.h"
+
+#include <string.h>
+
+#include "decoder.h"
+#include "defines.h"
+#include "lmath.h"
+
+B8
+TrackOpen(Track *track, const char *path) {
+    strcpy(track->path, path);
+
+    if (!DecoderOpen(&track->decoder, path)) {
+        return false;
+    }
+
+    track->head_count =
+        DecoderRead(&track->decoder, track->head, TRACK_HEAD_FRAMES);
+    track->head_cursor = 0;
+
+    return true;
+}
+
+void
+TrackClose(Track *track) {
+    DecoderClose(&track->decoder);
+}
+
+// Serves frames from the head first, then from the decoder, which was left
+// positioned just past the head.
+U32
+TrackRead(Track *track, F32 *frames, U32 frame_count) {
+    U32 channels = track->decoder.channels;
+    U32 count = MinU32(frame_count, track->head_count - track->head_cursor);
+
+    memcpy(frames, track->head + track->head_cursor * channels,
+           count * channels * sizeof(F32));
+    track->head_cursor += count;
+
+    if (count < frame_count) {
+        count += DecoderRead(&track->decoder, frames + count * channels,
+                             frame_count - count);
+    }
+
+    return count;
+}
+
+B8
+TrackSeek(Track *track, U64 frame) {
+    if (frame < track->head_count) {
+        track->head_cursor = frame;
+        return DecoderSeek(&track->decoder, track->head_count);
+    }
+
+    track->head_cursor = track->head_count;
+    return DecoderSeek(&track->decoder, frame);
+}
@@ -0,0 +1,27 @@
+#pragma once
+
+#include "decoder.h"
+#include "defines.h"
+
+// Frames decoded ahead of time when a track is opened. Covers the first few
+// stream refills, so playback can start without touching the decoder.
+#define TRACK_HEAD_FRAMES 8192
+
+// An open decoder plus its first frames.
+typedef struct Track {
+    char    path[256];
+    Decoder decoder;
+
+    U32 head_count;
+    U32 head_cursor;
+    F32 head[TRACK_HEAD_FRAMES * DECODER_MAX_CHANNELS];
+} Track;
+
+B8
+TrackOpen(Track *track, const char *path);
+void
+TrackClose(Track *track);
+U32
+TrackRead(Track *track, F32 *frames, U32 frame_count);
+B8
+TrackSeek(Track *track, U64 frame);
@@ -8,25 +8,20 @@
 #include <string.h>
 
 UIToggleMenuData
-UIMeasureToggleMenu(HM_Hashmap *params,
-                    HM_Hashmap *procs,
+UIMeasureToggleMenu(Parameters *params,
+                    Procedures *procs,
                     StateFont   font,
                     F32         font_size,
                     F32         padding,
                     F32         toggle_width) {
     UIToggleMenuData data = {0};
 
-    U32 _, i = 0;
-
-    Parameter *parameter;
-    while (ParameterIter(params, &_, &parameter)) {
-        if (!parameter) {
-            continue;
-        }
+    U32 i = 0;
 
+    for (ParameterHandle p = 0; p < ParameterCount(params); ++p) {
         F32 offset =
             RayToHMMV2(MeasureTextEx(FontClosestToSize(font, font_size),
-                                     parameter->name, font_size, 1))
+                                     ParameterName(params, p), font_size, 1))
                 .X;
 
         if (offset > data.max_loffset) {
@@ -35,7 +30,8 @@ UIMeasureToggleMenu(HM_Hashmap *params,
 
         offset =
             RayToHMMV2(MeasureTextEx(FontClosestToSize(font, font_size),
-                                     TextFormat("[%.2f]", parameter->value),
+                                     TextFormat("[%.2f]",
+                                                ParameterGetValue(params, p)),
                                      font_size, 1))
                 .X;
 
@@ -46,28 +42,43 @@ UIMeasureToggleMenu(HM_Hashmap *params,
 
     // Measure procedure buttons
     data.proc_button_width = 200;
-    Procedure *proc;
-    _ = 0;
-    i = 0;
-    while (ProcedureIter(procs, &_, &proc)) {
-        if (!proc) {
-            continue;
-        }
-
+    for (i = 0; i < ProcedureCount(procs); ++i) {
         F32 width = MeasureTextEx(FontClosestToSize(font, font_size),
-                                  TextFormat("%s", proc->name), font_size, 1)
+                                  ProcedureName(procs, i), font_size, 1)
                         .x;
 
         if (width > data.proc_button_width) {
             data.proc_button_width = width;
         }
-
-        ++i;
     }
 
     return data;
 }
 
+void
+UIRenderProgress(F32         progress,
+                 const char *text,
+                 HMM_Vec2    center,
+                 F32         width,
+                 StateFont   font) {
+    F32 height = 6;
+    F32 border_size = 2;
+
+    RendererDrawTextCenter(FontClosestToSize(font, 20), text,
+                           HMM_V2(center.X, center.Y - 20), WHITE);
+
+    DrawRectangleRec((Rectangle){center.X - width / 2 - border_size,
+                                 center.Y - border_size,
+                                 width + 2 * border_size,
+                                 height + 2 * border_size},
+                     (Color){204, 204, 204, 255});
+
+    DrawRectangleRec((Rectangle){center.X - width / 2, center.Y,
+                                 width * ClampF32(progress, 0.0f, 1.0f),
+                                 height},
+                     (Color){137, 116, 185, 255});
+}
+
 B8
 UIRenderPopUp(F32         border_size,
               F32         height,
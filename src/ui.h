@@ -10,12 +10,18 @@ typedef struct UIToggleMenuData {
 } UIToggleMenuData;
 
 UIToggleMenuData
-UIMeasureToggleMenu(HM_Hashmap *params,
-                    HM_Hashmap *procs,
+UIMeasureToggleMenu(Parameters *params,
+                    Procedures *procs,
                     StateFont   font,
                     F32         font_size,
                     F32         padding,
                     F32         toggle_width);
+void
+UIRenderProgress(F32         progress,
+                 const char *text,
+                 HMM_Vec2    center,
+                 F32         width,
+                 StateFont   font);
 B8
 UIRenderPopUp(F32         border_size,
               F32         height,